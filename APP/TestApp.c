@@ -50,10 +50,12 @@ U8 TestItemArray[CH_PERCFG_MAX] =
 "0111:RFM Start,FCT+MCUSTART,OK,ERROR,,,AUXCMD,,2,\r\n"   //Notify RFM to enter FCT mode.
 "0112:CW Start,FCT+CW=1,CW:1,ERROR,,,CMD,,,\r\n"         //Notify DUT to enter TX carrier status.
 "0113:RSSI Test,FCT+RSSI?,RSSI:,,55,68,RSSI_T,,2,2\r\n"  //Get RSSI of RFM, Calculate the average and variance.      
+//"0113:RSSI Test,FCT+RSSI=50,RSSI:,,55,68,RSSIS_T,,2,2\r\n"  //RFM streams 50 RSSI samples, stop as soon as the result is clear.
 "0114:CW End,FCT+CW=0,CW:0,ERROR,,,CMD,,,\r\n"           //Notify DUT to exit TX carrier status.
 "0115:RF Mode,FCT+DATAMODE=0,OK,ERROR,,,AUXCMD,,2,\r\n"  //Notify RFM to enter FCT data Mode.
 "0115:RF Data,FCT+DATA=1,OK,ERROR,,,AUXCMD,,2,\r\n"      //Notify RFM to enter receive data.
 "0115:RF Test,FCT+DATA?,DATA:,ERROR,,,RFDA_T,,2,3\r\n"   //RF Data test. From DUT to RFM.
+//"0115:RF PER,FCT+RFDATA=,DATA:,,100,5,RFPER_T,,2,20\r\n"   //100 numbered packets 20ms apart, PER < 5%, stop once clear.
 "0115:RF Data,FCT+DATA=0,OK,ERROR,,,AUXCMD,,2,\r\n"      //Notify RFM to enter receive data.
 "0115:RF Mode,FCT+DATAMODE=1,OK,ERROR,,,AUXCMD,,2,\r\n"  //Notify RFM to enter Normal data mode
 
@@ -87,6 +89,7 @@ U8 TestItemArray[CH_PERCFG_MAX] =
 ;
 
 #define RF_DATA_SAMPLE		50
+#define RF_DATA_SAMPLE_MIN	10      // RSSI samples before an early decision
 #define RF_DATA_TIMES_MAX   20
 #define RF_DUT_COMM_PORT    USART1
 #define RF_MODULE_COMM_PORT USART2
@@ -101,65 +104,82 @@ void TEST_APP_RssiTest(P_ITEM_T pitem)
 {
 	U32 i;
 	U32 getRssi;
-	U8 rssiSamp[RF_DATA_SAMPLE];
-	U32 diff;
-	U32 Average  = 0;
-	U32 Variance = 0;
+	STAT_ACC acc;
+	S32 Average;
+	U32 Variance;
 	U32 VarLmtMax;
+	U32 verdict = STAT_UNSURE;
 
-	VarLmtMax = pitem->Param;
+	VarLmtMax = (U32)pitem->Param * 1000000;    //dBm^2, 1000
 
 	Cmd_ReadData(pitem->Channel,&getRssi, pitem);	// Is a dummy operation
 	OS_Delay(10);
 	
-	//Get Samples
-	for(i=0; i<RF_DATA_SAMPLE; i++){
+	//Get Samples, ƽֵ(ҷ)ʱǰ
+	Stat_Reset(&acc);
+	for(i=0; i<RF_DATA_SAMPLE && verdict == STAT_UNSURE; i++){
 		if(Cmd_ReadData(pitem->Channel,&getRssi, pitem)){
-		    rssiSamp[i] = getRssi;   //dBm Conver
-            Dprintf("-%d,", rssiSamp[i]);
+		    Stat_Add(&acc, getRssi * 1000);   //dBm Conver, lower/upperλͬ
+		    RFREC_CwAdd(getRssi * 1000);      //ֱֻͼ, ӡ
 		}
         else{
-            break;
+    	    pitem->retResult = FAIL;
+    	    RFREC_Cw(pitem->Channel, &acc, pitem->lower, pitem->upper, FAIL);
+    	    return;
+		}
+		if(acc.n >= RF_DATA_SAMPLE_MIN){
+		    verdict = Stat_CiCheck(&acc, pitem->lower, pitem->upper, STAT_Z_997);
+		    if(verdict == STAT_INSIDE && Stat_Var(&acc) > VarLmtMax){
+		        verdict = STAT_UNSURE;
+		    }
 		}
 		OS_Delay(10);
 	}
-	if(i < RF_DATA_SAMPLE){
-	    pitem->retResult = FAIL;
-	    return;
-	}
 
-	//Get Average
-	for(i=0; i<RF_DATA_SAMPLE; i++){
-		Average += rssiSamp[i];
-	}
-	Average /= RF_DATA_SAMPLE;
-
-	//Get Variance
-	for(i=0; i<RF_DATA_SAMPLE; i++){
-	    if(rssiSamp[i] >= Average){
-            diff = rssiSamp[i] - Average;
-	    }
-	    else{
-            diff = Average - rssiSamp[i];
-	    }
-	    diff = diff * diff;
-		Variance += diff;
-	}
-	Variance /= RF_DATA_SAMPLE;
-    Dprintf("\r\nAverage = %d, Variance = %d\r\n", Average, Variance);
+	Average  = Stat_Mean(&acc);
+	Variance = Stat_Var(&acc);
+    Dprintf("RSSI: %d samples, Average = %d, Variance = %d, Cpk = %d\r\n", acc.n, Average, Variance,
+            Stat_Cpk100(&acc, pitem->lower, pitem->upper));
     
     //check 
     if(Variance <= VarLmtMax){
-        pitem->lower /= 1000;
-        pitem->upper /= 1000;
+        pitem->retResult = Stat_Limit(pitem, Average);
+    }
+    else{
+	    pitem->retResult = FAIL;
+	}
+    RFREC_Cw(pitem->Channel, &acc, pitem->lower, pitem->upper, pitem->retResult);
+}
 
-    	if(Average >= pitem->lower && Average <= pitem->upper){
-            pitem->retResult = PASS;
-            return;
-    	}
+/******************************************************************************
+    Routine Name    : TEST_APP_RssiStream
+    Parameters      : pitem
+    Return value    : PASS/FAIL
+    Description     : RF RSSI, ģʽ: ֻһ, RFMRF_DATA_SAMPLERSSI,
+                      ձƽֵͷ, ȷʱǰ. ParamΪ(dBm^2)
+******************************************************************************/
+void TEST_APP_RssiStream(P_ITEM_T pitem)
+{
+    RSP_SPEC spec;
+    STREAM_CHK chk;
+
+    Cmd_SetSpec(&spec, pitem->RspCmdPass, pitem->RspCmdFail, RSP_PREFIX, 1000);  //RSSI1000ȡֵ, lower/upperͬ
+    spec.poll_ms = 2;
+
+    chk.lower    = pitem->lower;
+    chk.upper    = pitem->upper;
+    chk.varMax   = (U32)pitem->Param * 1000000;
+    chk.minCount = RF_DATA_SAMPLE_MIN;
+    chk.absVal   = TRUE;      //dBm Conver
+
+    if(Cmd_StreamCheck(pitem->Channel, pitem->TestCmd, &spec, RF_DATA_SAMPLE, &chk))
+    {
+        pitem->retResult = PASS;
+    }
+    else
+    {
+        pitem->retResult = FAIL;
     }
-    
-	pitem->retResult = FAIL;
 }
 
 /******************************************************************************
@@ -173,6 +193,9 @@ void TEST_APP_RFDA_Test(P_ITEM_T pitem)
     U32 i;
     U32 fail_cnt = 0;
     U32 chk;
+    U32 verdict = STAT_UNSURE;
+    U32 limit;
+    STAT_SPRT sprt;
 
     U8 TestDataTx[12+1]="313233343536"; //RFģҪ͵
     U8 TestDataRx[12+1]="313233343536"; //DUTյ
@@ -182,7 +205,11 @@ void TEST_APP_RFDA_Test(P_ITEM_T pitem)
     
     TestFailMax = pitem->Param;
 
-    for(i=0; i<RF_DATA_TIMES_MAX; i++)   // Odd frames can not be received successfully?
+    // : Ϊ޵1/4ð, 2㻵, ȷֹͣ
+    limit = (TestFailMax + 1) * 1000 / RF_DATA_TIMES_MAX;
+    Stat_SprtInit(&sprt, limit / 4, limit * 2, STAT_SPRT_CONF);
+
+    for(i=0; i<RF_DATA_TIMES_MAX && verdict == STAT_UNSURE; i++)   // Odd frames can not be received successfully?
     {
         TestDataTx[11] = (i<<1)%10+'0';  // Format string to "12345X", X:even
         TestDataRx[11] = (i<<1)%10+'0';
@@ -197,6 +224,7 @@ void TEST_APP_RFDA_Test(P_ITEM_T pitem)
             //chk=Cmd_Ack(RF_MODULE_COMM_PORT,"FCT+DATA?",exp_str,pitem->RspCmdFail);//ȡRF,У
         }
         
+        verdict = Stat_SprtAdd(&sprt, chk);
         if(chk == FALSE)
         {
             Dprintf("Package%d failed!\r\n", i);
@@ -207,16 +235,182 @@ void TEST_APP_RFDA_Test(P_ITEM_T pitem)
             }
         }
     }
+    Dprintf("RF data: %d packages, %d failed\r\n", sprt.n, sprt.ng);
 
-    if(fail_cnt <= TestFailMax){
+    if(verdict == STAT_UNSURE){
+        verdict = (fail_cnt <= TestFailMax) ? STAT_INSIDE : STAT_OUTSIDE;
+    }
+    if(verdict == STAT_INSIDE){
 	    pitem->retResult = PASS;
 	}
 	else{
 	    pitem->retResult = FAIL;
 	}
+    RFREC_Data(pitem->Channel, sprt.n, sprt.ng, pitem->retResult);
     OS_Delay(300);  // For next step
 }
 
+/*
+    RFʲ: DUTNŵİ, ɵ, RFģӦ,
+    ÿμRFģյ, . RF_PER_LATE_MSûյ
+    İ㶪ʧ(֮յյ). ʵ95% Wilsonֵ
+    ֵʱǰ.
+*/
+#define RF_PER_MAX          200             //
+#define RF_PER_DEF          100
+#define RF_PER_GAP_MS       20
+#define RF_PER_LATE_MS      300             //Cmd_Listenĵȴʱͬ
+#define RF_PER_MIN          20              //ôнǰж
+#define RF_PER_PAYLOAD      "31323334"      //4λʮ
+
+#define RF_PKT_WAIT         0
+#define RF_PKT_RX           1
+#define RF_PKT_LOST         2
+
+typedef struct
+{
+    U32 sent;
+    U32 done;           //н(յʱ)İ
+    U32 lost;
+    U32 per;            // %x1000, limitλͬ
+    U32 perLo;          //95%
+    U32 perHi;
+    STAT_ACC rssi;      //RFģݺ",RSSI"ʱÿRSSI, x1000
+
+} RF_PER, * P_RF_PER;
+
+static RF_PER RfPer;
+static U32 RfPerTime[RF_PER_MAX];  //ʱ
+static U8  RfPerState[RF_PER_MAX];
+
+static void RfPer_Receive(U8 * prefix, U32 sent)
+{
+    U8 line[64];
+    U8 * s;
+    U32 seq;
+    U32 len = strlen((char * )prefix);
+    U32 plen = strlen(RF_PER_PAYLOAD);
+
+    while(Cmd_GetLine(RF_MODULE_COMM_PORT, line, sizeof(line)))
+    {
+        if(strncmp((char * )line, (char * )prefix, len) || strncmp((char * )line + len, RF_PER_PAYLOAD, plen))
+        {
+            continue;
+        }
+        s = line + len + plen;
+        seq = strtoul((char * )s, (char ** )&s, 10);
+        if(seq >= sent || RfPerState[seq] == RF_PKT_RX)     //Ŵظ
+        {
+            continue;
+        }
+
+        if(RfPerState[seq] == RF_PKT_LOST)  //ٵ
+        {
+            RfPer.lost--;
+        }
+        else
+        {
+            RfPer.done++;
+        }
+        RfPerState[seq] = RF_PKT_RX;
+
+        if(*s == ',')
+        {
+            Stat_Add(&RfPer.rssi, abs(atoi((char * )s + 1)) * 1000);
+        }
+    }
+}
+
+static void RfPer_Expire(U32 sent)
+{
+    U32 i;
+    U32 now = OS_GetTime32();
+
+    for(i = 0; i < sent; i++)
+    {
+        if(RfPerState[i] == RF_PKT_WAIT && now - RfPerTime[i] >= RF_PER_LATE_MS)
+        {
+            RfPerState[i] = RF_PKT_LOST;
+            RfPer.lost++;
+            RfPer.done++;
+            Dprintf("Package%d lost!\r\n", i);
+        }
+    }
+}
+
+/******************************************************************************
+    Routine Name    : TEST_APP_RfPerTest
+    Parameters      : pitem, TestCmd DUT(Ϊ"FCT+RFDATA="),
+                      RspCmdPass RFģյݵǰ׺(Ϊ"DATA:"),
+                      lower (Ϊ100), upper %, Param ms
+    Return value    : PASS/FAIL
+    Description     : RF
+******************************************************************************/
+void TEST_APP_RfPerTest(P_ITEM_T pitem)
+{
+    U32 num, gap, sent = 0;
+    U32 verdict = STAT_UNSURE;
+    U8 tx_str[CMD_STR_MAX + 16];
+    U8 * txCmd = pitem->TestCmd[0] ? pitem->TestCmd : (U8 * )"FCT+RFDATA=";
+    U8 * rxPre = pitem->RspCmdPass[0] ? pitem->RspCmdPass : (U8 * )"DATA:";
+
+    num = pitem->lower / 1000;
+    if(num == 0 || num > RF_PER_MAX)
+    {
+        num = (num == 0) ? RF_PER_DEF : RF_PER_MAX;
+    }
+    gap = pitem->Param ? pitem->Param : RF_PER_GAP_MS;
+
+    memset(&RfPer, 0, sizeof(RfPer));
+    Stat_Reset(&RfPer.rssi);
+    memset(RfPerState, RF_PKT_WAIT, sizeof(RfPerState));
+    UsartRecvReset(RF_MODULE_COMM_PORT);
+
+    while(RfPer.done < num && verdict == STAT_UNSURE)
+    {
+        if(sent < num)
+        {
+            sprintf((char * )tx_str, "%s%s%04d", txCmd, RF_PER_PAYLOAD, sent);
+            RfPerTime[sent] = OS_GetTime32();
+            Cmd_Ack(RF_DUT_COMM_PORT, tx_str, "OK", "ERROR");  //DUTܾ͵İᳬʱ㶪ʧ
+            RfPer.sent = ++sent;
+        }
+        OS_Delay(gap);
+
+        RfPer_Receive(rxPre, sent);
+        RfPer_Expire(sent);
+
+        if(RfPer.done >= RF_PER_MIN)
+        {
+            Stat_Wilson(RfPer.lost, RfPer.done, STAT_Z_95, &RfPer.perLo, &RfPer.perHi);
+            if(RfPer.perHi <= pitem->upper)
+            {
+                verdict = STAT_INSIDE;
+            }
+            else if(RfPer.perLo > pitem->upper)
+            {
+                verdict = STAT_OUTSIDE;
+            }
+        }
+    }
+
+    Stat_Wilson(RfPer.lost, RfPer.done, STAT_Z_95, &RfPer.perLo, &RfPer.perHi);
+    RfPer.per = RfPer.done ? RfPer.lost * STAT_RATE_FULL / RfPer.done : STAT_RATE_FULL;
+    Dprintf("RF PER: %d of %d lost, %d.%03d%% (%d.%03d~%d.%03d%%)\r\n", RfPer.lost, RfPer.done,
+            RfPer.per/1000, RfPer.per%1000, RfPer.perLo/1000, RfPer.perLo%1000, RfPer.perHi/1000, RfPer.perHi%1000);
+    if(RfPer.rssi.n)
+    {
+        Dprintf("RSSI: -%d dBm, -%d~-%d\r\n", Stat_Mean(&RfPer.rssi)/1000, RfPer.rssi.min/1000, RfPer.rssi.max/1000);
+    }
+
+    if(verdict == STAT_UNSURE)
+    {
+        verdict = (RfPer.per <= pitem->upper) ? STAT_INSIDE : STAT_OUTSIDE;
+    }
+    pitem->retResult = (verdict == STAT_INSIDE) ? PASS : FAIL;
+    RFREC_Per(pitem->Channel, RfPer.sent, RfPer.lost, RfPer.per, RfPer.perLo, RfPer.perHi, &RfPer.rssi, pitem->retResult);
+}
+
 /******************************************************************************
     Routine Name    : TEST_APP_Current
     Parameters      : pitem
@@ -236,12 +430,7 @@ void TEST_APP_Current(P_ITEM_T pitem)
     OS_Delay(50);
     curr=volt/1000;
     Dprintf("current:%dnA\r\n", curr);
-    if((curr > pitem->lower) && (curr < pitem->upper)){
-        pitem->retResult = PASS;
-    }
-    else{
-        pitem->retResult = FAIL;
-    }
+    pitem->retResult = Stat_Limit(pitem, curr);
 }
 
 /******************************************************************************
@@ -339,7 +528,9 @@ void TEST_APP_Tamper(P_ITEM_T pitem)
 const TEST_ID TestAppIdTab[] = 
 {
 	{"RSSI_T", TEST_APP_RssiTest},
+	{"RSSIS_T", TEST_APP_RssiStream},
 	{"RFDA_T", TEST_APP_RFDA_Test},
+	{"RFPER_T", TEST_APP_RfPerTest},
     {"CUR_T",  TEST_APP_Current},
     {"SN_T",   TEST_APP_CheckSN},    
     {"TAMP_T", TEST_APP_Tamper},
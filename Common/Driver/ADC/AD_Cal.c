@@ -0,0 +1,222 @@
+/******************************************************************************
+    AD_Cal.c
+    Piecewise-linear calibration of the ADC ranges
+
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+
+    A range calibrated at two or more points keeps a table of (raw, ref)
+    pairs sorted by raw, and a reading is corrected on the segment it falls
+    in, or on the first/last segment outside the table. The slope of every
+    segment is worked out when the table is loaded, so a correction is one
+    short scan and one multiply. A range calibrated at one point only gets a
+    gain in Init.csv, as before. The tables are kept in AdCal.bin.
+******************************************************************************/
+#include "includes.h"
+
+#define AD_CAL_MAGIC        (0x314C4143)    // "CAL1"
+#define AD_CAL_MIN_GAP      (1000)          // uV between two points of a range
+#define AD_CAL_Q            (24)
+
+typedef struct
+{
+    U32 magic;
+    U32 num[AD_RANGE_NUM];
+    AD_CAL_PT pt[AD_RANGE_NUM][AD_CAL_PTS];
+
+} AD_CAL_TAB;
+
+static AD_CAL_TAB AdCalTab;
+static S32 AdCalSlope[AD_RANGE_NUM][AD_CAL_PTS];    // ref/raw of segment i..i+1, Q24
+
+static AD_CAL_PT AdCalNew[AD_RANGE_NUM][AD_CAL_PTS];
+static U32 AdCalNewNum[AD_RANGE_NUM];
+
+static void AD_CalSlopes(void)
+{
+    U32 r, i;
+    P_AD_CAL_PT pt;
+
+    memset(AdCalSlope, 0, sizeof(AdCalSlope));
+    for(r = 0; r < AD_RANGE_NUM; r++)
+    {
+        pt = AdCalTab.pt[r];
+        for(i = 0; i + 1 < AdCalTab.num[r]; i++)
+        {
+            AdCalSlope[r][i] = (S32)(((S64)(pt[i + 1].ref - pt[i].ref) << AD_CAL_Q) / (pt[i + 1].raw - pt[i].raw));
+        }
+    }
+}
+
+/******************************************************************************
+    Routine Name    : AD_CalInit
+    Parameters      : none
+    Return value    : none
+    Description     : Load the tables, call it before i2c_ADC_init().
+******************************************************************************/
+void AD_CalInit(void)
+{
+    FS_FILE *fb;
+    U32 r;
+
+    memset(&AdCalTab, 0, sizeof(AdCalTab));
+
+    if(fb = FS_FOpen(AD_CAL_FILE,"rb"))
+    {
+        if(FS_FRead(&AdCalTab, sizeof(AdCalTab), 1, fb) != 1 || AdCalTab.magic != AD_CAL_MAGIC)
+        {
+            memset(&AdCalTab, 0, sizeof(AdCalTab));
+        }
+        FS_FClose(fb);
+    }
+
+    for(r = 0; r < AD_RANGE_NUM; r++)
+    {
+        if(AdCalTab.num[r] < 2 || AdCalTab.num[r] > AD_CAL_PTS)
+        {
+            AdCalTab.num[r] = 0;
+        }
+    }
+    AD_CalSlopes();
+}
+
+BOOL AD_CalActive(INT32U val_range)
+{
+    if(val_range < _RANGE_0_2V || val_range > _RANGE_0_200V)
+    {
+        return(FALSE);
+    }
+    return((AdCalTab.num[val_range - 1] >= 2) ? TRUE : FALSE);
+}
+
+/******************************************************************************
+    Routine Name    : AD_CalApply
+    Parameters      : val_range, uv, reading without calibration
+    Return value    : calibrated uV
+    Description     : Correct a reading with the table of its range.
+******************************************************************************/
+INT32U AD_CalApply(INT32U val_range, INT32U uv)
+{
+    U32 i, n;
+    S64 y;
+    P_AD_CAL_PT pt;
+
+    if(AD_CalActive(val_range) == FALSE)
+    {
+        return(uv);
+    }
+
+    n  = AdCalTab.num[val_range - 1];
+    pt = AdCalTab.pt[val_range - 1];
+    for(i = 0; i < n - 2 && (S32)uv >= pt[i + 1].raw; i++)
+    {
+        ;
+    }
+
+    y = pt[i].ref + ((((S64)uv - pt[i].raw) * AdCalSlope[val_range - 1][i]) >> AD_CAL_Q);
+    return((y > 0) ? (INT32U)y : 0);
+}
+
+/******************************************************************************
+    Routine Name    : AD_CalBegin
+    Parameters      : none
+    Return value    : none
+    Description     : Start a calibration session.
+******************************************************************************/
+void AD_CalBegin(void)
+{
+    memset(AdCalNew, 0, sizeof(AdCalNew));
+    memset(AdCalNewNum, 0, sizeof(AdCalNewNum));
+}
+
+/******************************************************************************
+    Routine Name    : AD_CalAddPoint
+    Parameters      : val_range, raw_uv (from AD_ReadRawUv), ref_uv
+    Return value    : FALSE if the range is full or has a point too close
+    Description     : Add a point of the session, kept sorted by raw.
+******************************************************************************/
+BOOL AD_CalAddPoint(INT32U val_range, INT32U raw_uv, INT32U ref_uv)
+{
+    U32 i, n;
+    P_AD_CAL_PT pt;
+
+    if(val_range < _RANGE_0_2V || val_range > _RANGE_0_200V || raw_uv == 0)
+    {
+        return(FALSE);
+    }
+
+    n  = AdCalNewNum[val_range - 1];
+    pt = AdCalNew[val_range - 1];
+    if(n >= AD_CAL_PTS)
+    {
+        return(FALSE);
+    }
+    for(i = 0; i < n; i++)
+    {
+        if(abs(pt[i].raw - (S32)raw_uv) < AD_CAL_MIN_GAP)
+        {
+            return(FALSE);
+        }
+    }
+
+    for(i = n; i > 0 && pt[i - 1].raw > (S32)raw_uv; i--)
+    {
+        pt[i] = pt[i - 1];
+    }
+    pt[i].raw = (S32)raw_uv;
+    pt[i].ref = (S32)ref_uv;
+    AdCalNewNum[val_range - 1] = n + 1;
+    return(TRUE);
+}
+
+/******************************************************************************
+    Routine Name    : AD_CalCommit
+    Parameters      : none
+    Return value    : TRUE if any range has been calibrated
+    Description     : Use and save the points of the session. Ranges without
+                      a new point keep their calibration.
+******************************************************************************/
+BOOL AD_CalCommit(void)
+{
+    FS_FILE *fb;
+    U32 r;
+    BOOL res = FALSE;
+
+    for(r = 0; r < AD_RANGE_NUM; r++)
+    {
+        if(AdCalNewNum[r] == 0)
+        {
+            continue;
+        }
+        res = TRUE;
+
+        if(AdCalNewNum[r] == 1)     // one point: a gain only
+        {
+            AdCalTab.num[r] = 0;
+            AD_SetCal(_RANGE_0_2V + r, (U32)((S64)AdCalNew[r][0].ref * AD_GAIN_UNITY / AdCalNew[r][0].raw), 0);
+        }
+        else
+        {
+            AdCalTab.num[r] = AdCalNewNum[r];
+            memcpy(AdCalTab.pt[r], AdCalNew[r], sizeof(AdCalNew[r]));
+            AD_SetCal(_RANGE_0_2V + r, AD_GAIN_UNITY, 0);   // the table is made on raw readings
+        }
+    }
+    AD_CalSlopes();
+
+    if(res)
+    {
+        AdCalTab.magic = AD_CAL_MAGIC;
+        if(fb = FS_FOpen(AD_CAL_FILE,"wb"))
+        {
+            FS_FWrite(&AdCalTab, sizeof(AdCalTab), 1, fb);
+            FS_SetEndOfFile(fb);
+            FS_FClose(fb);
+        }
+    }
+    return(res);
+}
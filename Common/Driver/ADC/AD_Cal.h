@@ -0,0 +1,38 @@
+/*****************************************************************************
+    AD_Cal.h
+    Piecewise-linear calibration of the ADC ranges
+
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+******************************************************************************/
+
+#ifndef _AD_CAL_H_
+#define _AD_CAL_H_
+
+#include "includes.h"
+
+#define AD_CAL_PTS      (8)             // points per range
+#define AD_CAL_FILE     "AdCal.bin"
+
+typedef struct
+{
+    S32 raw;                            // reading without calibration, uV
+    S32 ref;                            // voltage connected, uV
+
+} AD_CAL_PT, * P_AD_CAL_PT;
+
+extern void   AD_CalInit(void);
+extern BOOL   AD_CalActive(INT32U val_range);
+extern INT32U AD_CalApply(INT32U val_range, INT32U uv);
+
+extern void   AD_CalBegin(void);
+extern BOOL   AD_CalAddPoint(INT32U val_range, INT32U raw_uv, INT32U ref_uv);
+extern BOOL   AD_CalCommit(void);
+
+#endif
+
+/*********************************** EOF **************************************/
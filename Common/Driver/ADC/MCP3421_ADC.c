@@ -23,7 +23,9 @@
 #define TC_CLKS_MCK32            0x2
 #define TC_CLKS_MCK128           0x3
 
-#define TIMER_PERIOD_5US         100    // TC_CLKS_MCK2, 100MHz
+#define I2C_ADC_MCK_KHZ          (99328)    // OS_FSYS/2, RTOSInit_AT91SAM9260.c
+#define I2C_TICK_US              (10)       // TC5 interrupt period
+#define TIMER_PERIOD_TICK        (I2C_ADC_MCK_KHZ / 2 * I2C_TICK_US / 1000)   // TC_CLKS_MCK2
 
 #define ADC_GPIO_ID         AT91C_ID_PIOC
 #define ADC_GPIO_RANG10     AT91C_PIO_PC6
@@ -44,21 +46,19 @@
 #define LIMIT_16BIT       (0xFFFF)
 #define LIMIT_18BIT       (0x3FFFF)
 
-static float  verify_coef_range_1to1  ;   // ޷ѹϵ
-static float  verify_coef_range_10to1 ;   // 10:1 ѹϵ
-static float  verify_coef_range_100to1;   // 100:1 ѹϵ
-
-static void i2c_ADC_delay(void);
-static void i2c_ADC_SDA_Output(int data);
-static unsigned char i2c_ADC_SDA_Input(void);
-static void i2c_ADC_SCL_Output(int data);
-static void i2c_ADC_Start(void);
-static void i2c_ADC_Stop(void);
-static void i2c_ADC_SendByte(unsigned char ch);
-static unsigned char i2c_ADC_ReceiveByte(void);
-static int  i2c_ADC_WaitAck(void);
-static void i2c_ADC_SendAck(void);
-static void i2c_ADC_SendNotAck(void);
+/*
+    Integer conversion path: a filtered reading is an average code in Q4, and
+    AdMul[range][precision] turns it into uV. AdMul is built by AD_SetCal()
+    from the gain (ppm) of the range, the divider and the LSB size, so a
+    reading costs one 64 bit multiply and no soft-float call.
+*/
+#define AD_CODE_Q       (4)
+#define AD_MUL_Q        (24)
+
+static INT32U AdGainPpm[AD_RANGE_NUM] = { AD_GAIN_UNITY, AD_GAIN_UNITY, AD_GAIN_UNITY };
+static S32    AdOfsUv[AD_RANGE_NUM];
+static INT64U AdMul[AD_RANGE_NUM][4];       // uV per code, Q24
+static const INT32U AdLimit[4] = { LIMIT_12BIT, LIMIT_14BIT, LIMIT_16BIT, LIMIT_18BIT };
 
 static void ADC_VoltIn_1to1_ENABLE();
 static void ADC_VoltIn_10to1_ENABLE();
@@ -66,7 +66,172 @@ static void ADC_VoltIn_100to1_ENABLE();
 
 static INT8U i2c_ADC3421_ConfigADC(unsigned char configValue);
 static INT8U i2c_ADC3421_readVoltage(INT8U * pVoltage, INT8U length);
-static INT32U ADC_value_no_verify(INT32U val_range, INT32U val_precision);
+static INT32U ADC_ReadFiltered(INT32U val_precision, INT32U n);
+static void AD_CalBuild(INT32U val_range);
+
+/*
+    The I2C bus of the MCP3421 is on PC11/PC13, not on the TWI pins (PA23/PA24),
+    so the bit sequence is still generated by software, but no longer with the
+    CPU spinning on TC5. A transfer is first compiled into a list of pin
+    operations, then the TC5 compare interrupt runs it, one I2C_OP_WAIT per
+    I2C_TICK_US tick, while the calling task sleeps on I2cAdc_Done. A bit takes
+    two ticks (SCL high, SCL low with the next SDA), so SCL runs at 50kHz and
+    a 4 byte read is about 100 interrupts. With the caches off the embOS IRQ
+    entry and exit costs about 2us, so the tick is kept well above that and
+    the tasks still get most of the CPU during a transfer. Build with
+    DEBUG_I2C_LOAD to print the share of the transfer spent in the handler.
+*/
+#define I2C_OP_END          (0)     // transfer finished
+#define I2C_OP_WAIT         (1)     // end of this tick
+#define I2C_OP_SDA_H        (2)
+#define I2C_OP_SDA_L        (3)
+#define I2C_OP_SCL_H        (4)
+#define I2C_OP_SCL_L        (5)
+#define I2C_OP_SDA_IN       (6)     // release SDA
+#define I2C_OP_SDA_OUT      (7)
+#define I2C_OP_ACK          (8)     // wait for the slave to pull SDA low
+#define I2C_OP_BIT          (9)     // shift SDA into the receive byte
+#define I2C_OP_SAVE         (10)    // store the receive byte
+
+#define I2C_PROG_SIZE       (384)   // a 4 byte read needs about 270 ops
+#define I2C_RX_SIZE         (4)
+#define I2C_ADC_TMO_MS      (20)    // a transfer takes about 1ms
+
+#ifdef DEBUG_IRNORE_I2C
+#define I2C_ACK_TICKS       (3)
+#else
+#define I2C_ACK_TICKS       (1000 / I2C_TICK_US)    // 1ms
+#endif
+
+static U8  I2cProg[I2C_PROG_SIZE];
+static U32 I2cLen;                  // ops in I2cProg
+static U32 I2cStop;                 // first op of the final stop, where a NACK jumps to
+static U8  I2cRx[I2C_RX_SIZE];
+static U32 I2cRxNum;                // bytes the program receives
+
+static volatile U32 I2cPc;
+static volatile U32 I2cAckTicks;
+static volatile U32 I2cRxCnt;
+static volatile U8  I2cRxByte;
+static volatile BOOL I2cNack;
+
+static OS_CSEMA I2cAdc_Done;
+static OS_RSEMA I2cAdc_Lock;
+static BOOL I2cAdc_Ready = FALSE;
+
+#ifdef DEBUG_I2C_LOAD
+static volatile U32 I2cIsrCycles;   // OS_GetTime_Cycles() spent in the handler
+static volatile U32 I2cIsrCount;
+#endif
+
+/******************************************************************************
+    Routine Name    : i2c_ADC_Tick
+    Form            : void i2c_ADC_Tick(void)
+    Parameters      : none
+    Return value    : none
+    Description     : Run the ops of one tick.
+******************************************************************************/
+static void i2c_ADC_Tick(void)
+{
+    U8 op;
+
+    for(;;)
+    {
+        op = I2cProg[I2cPc++];
+        switch(op)
+        {
+            case I2C_OP_WAIT:
+                return;
+
+            case I2C_OP_SDA_H:
+                I2C_ADC_BASE->PIO_SODR = I2C_ADC_SDA;
+                break;
+
+            case I2C_OP_SDA_L:
+                I2C_ADC_BASE->PIO_CODR = I2C_ADC_SDA;
+                break;
+
+            case I2C_OP_SCL_H:
+                I2C_ADC_BASE->PIO_SODR = I2C_ADC_SCL;
+                break;
+
+            case I2C_OP_SCL_L:
+                I2C_ADC_BASE->PIO_CODR = I2C_ADC_SCL;
+                break;
+
+            case I2C_OP_SDA_IN:
+                I2C_ADC_BASE->PIO_ODR = I2C_ADC_SDA;
+                break;
+
+            case I2C_OP_SDA_OUT:
+                I2C_ADC_BASE->PIO_OER = I2C_ADC_SDA;
+                break;
+
+            case I2C_OP_ACK:
+                if((I2C_ADC_BASE->PIO_PDSR & I2C_ADC_SDA) == 0)
+                {
+                    I2cAckTicks = I2C_ACK_TICKS;
+                    break;
+                }
+                if(--I2cAckTicks)
+                {
+                    I2cPc--;                // look again next tick
+                    return;
+                }
+                // no ACK, release the bus and send the stop
+                I2C_ADC_BASE->PIO_OER  = I2C_ADC_SDA;
+                I2C_ADC_BASE->PIO_SODR = I2C_ADC_SDA;
+                I2C_ADC_BASE->PIO_CODR = I2C_ADC_SCL;
+                I2cAckTicks = I2C_ACK_TICKS;
+                I2cNack = TRUE;
+                I2cPc = I2cStop;
+                break;
+
+            case I2C_OP_BIT:
+                I2cRxByte <<= 1;
+                if(I2C_ADC_BASE->PIO_PDSR & I2C_ADC_SDA)
+                {
+                    I2cRxByte |= 0x01;
+                }
+                break;
+
+            case I2C_OP_SAVE:
+                if(I2cRxCnt < I2C_RX_SIZE)
+                {
+                    I2cRx[I2cRxCnt++] = I2cRxByte;
+                }
+                I2cRxByte = 0;
+                break;
+
+            default:                        // I2C_OP_END
+                I2C_ADC_TC_BASE->TC_IDR = AT91C_TC_CPCS;
+                OS_SignalCSema(&I2cAdc_Done);
+                return;
+        }
+    }
+}
+
+/******************************************************************************
+    Routine Name    : i2c_ADC_Isr
+    Form            : void i2c_ADC_Isr(void)
+    Parameters      : none
+    Return value    : none
+    Description     : TC5 compare interrupt.
+******************************************************************************/
+static void i2c_ADC_Isr(void)
+{
+#ifdef DEBUG_I2C_LOAD
+    U32 t0 = OS_GetTime_Cycles();
+#endif
+
+    I2C_ADC_TC_BASE->TC_SR;
+    i2c_ADC_Tick();
+
+#ifdef DEBUG_I2C_LOAD
+    I2cIsrCycles += OS_GetTime_Cycles() - t0;
+    I2cIsrCount++;
+#endif
+}
 
 /******************************************************************************
     Routine Name    : i2c_init
@@ -91,8 +256,10 @@ static void ADC_init(void)
     I2C_ADC_BASE->PIO_OER = ADC_GPIO_RANG100;
 }
 
-void i2c_ADC_init(float coef_range_1to1, float coef_range_10to1, float coef_range_100to1)
+void i2c_ADC_init(void)
 {
+    INT32U r;
+
     I2C_ADC_BASE->PIO_PER     = I2C_ADC_SDA | I2C_ADC_SCL;
     I2C_ADC_BASE->PIO_SODR    = I2C_ADC_SDA | I2C_ADC_SCL;
     I2C_ADC_BASE->PIO_OER     = I2C_ADC_SDA | I2C_ADC_SCL;
@@ -115,98 +282,102 @@ void i2c_ADC_init(float coef_range_1to1, float coef_range_10to1, float coef_rang
 	I2C_ADC_TC_BASE->TC_SR;
 
 	// Set compare value.
-	I2C_ADC_TC_BASE->TC_RC         = TIMER_PERIOD_5US;
+	I2C_ADC_TC_BASE->TC_RC         = TIMER_PERIOD_TICK;
+
+    if(I2cAdc_Ready == FALSE)       // ADC_Test() calls this again
+    {
+        OS_CREATECSEMA(&I2cAdc_Done);
+        OS_CREATERSEMA(&I2cAdc_Lock);
+        I2cAdc_Ready = TRUE;
+    }
+    OS_ARM_InstallISRHandler(I2C_ADC_TC_ID, &i2c_ADC_Isr);
+    OS_ARM_ISRSetPrio(I2C_ADC_TC_ID, 0);
+    OS_ARM_EnableISR(I2C_ADC_TC_ID);
     
     ADC_init();
     
     //
-    verify_coef_range_1to1  = coef_range_1to1;
-    verify_coef_range_10to1 = coef_range_10to1;
-    verify_coef_range_100to1 = coef_range_100to1;
+    for(r = _RANGE_0_2V; r <= _RANGE_0_200V; r++)
+    {
+        AD_CalBuild(r);
+    }
 }
 
 /******************************************************************************
-    Routine Name    : i2c_delay
-    Form            : void i2c_delay(void)
-    Parameters      : none
+    Routine Name    : i2c_ADC_Op
+    Form            : void i2c_ADC_Op(U8 op)
+    Parameters      : op
     Return value    : none
-    Description     : Delay Function for I2C.
+    Description     : Append an op to the transfer being built.
 ******************************************************************************/
-static void i2c_ADC_delay(void)
+static void i2c_ADC_Op(U8 op)
 {
-	I2C_ADC_TC_BASE->TC_SR;
-
-	// Start timer5
-	I2C_ADC_TC_BASE->TC_CCR = AT91C_TC_SWTRG;
-
-	I2C_ADC_TC_BASE->TC_SR;
-
-#ifndef DEBUG_IRNORE_I2C
-    while((I2C_ADC_TC_BASE->TC_SR & AT91C_TC_CPCS) == 0)
+    if(I2cLen < I2C_PROG_SIZE - 1)  // the last op is always I2C_OP_END
     {
-    	;
+        I2cProg[I2cLen++] = op;
     }
-#endif
 }
 
-
 /******************************************************************************
-    Routine Name    : i2c_SDA_Output
-    Form            : void i2c_SDA_Output(int data)
-    Parameters      : int data
+    Routine Name    : i2c_ADC_Begin
+    Form            : void i2c_ADC_Begin(void)
+    Parameters      : none
     Return value    : none
-    Description     : Send SDA signal.
+    Description     : Start building a transfer, the caller holds I2cAdc_Lock.
 ******************************************************************************/
-static void i2c_ADC_SDA_Output(int data)
+static void i2c_ADC_Begin(void)
 {
-	if(data == 0)
-	{
-        I2C_ADC_BASE->PIO_CODR = I2C_ADC_SDA;
-	}
-	else
-	{
-        I2C_ADC_BASE->PIO_SODR = I2C_ADC_SDA;
-	}
+    I2cLen   = 0;
+    I2cStop  = 0;
+    I2cRxNum = 0;
 }
 
-
 /******************************************************************************
-    Routine Name    : i2c_SDA_Input
-    Form            : unsigned char i2c_SDA_Input(void)
+    Routine Name    : i2c_ADC_Run
+    Form            : BOOL i2c_ADC_Run(void)
     Parameters      : none
-    Return value    : Value of SDA
-    Description     : Get SDA signal.
+    Return value    : TRUE if every byte was acknowledged
+    Description     : Run the transfer from the TC5 interrupt and sleep until
+                      it is done.
 ******************************************************************************/
-static unsigned char i2c_ADC_SDA_Input(void)
+static BOOL i2c_ADC_Run(void)
 {
-    if ( (I2C_ADC_BASE->PIO_PDSR & I2C_ADC_SDA ) == I2C_ADC_SDA )
-	{
-	    return 0x01;
-	}
-	else
-	{
-		return 0x00;
-	}
-}
+#ifdef DEBUG_I2C_LOAD
+    U32 t0;
 
+    I2cIsrCycles = 0;
+    I2cIsrCount  = 0;
+    t0 = OS_GetTime_Cycles();
+#endif
 
-/******************************************************************************
-    Routine Name    : i2c_SCL_Output
-    Form            : void i2c_SCL_Output(int data)
-    Parameters      : int data
-    Return value    : none
-    Description     : Send SCL signal.
-******************************************************************************/
-static void i2c_ADC_SCL_Output(int data)
-{
-	if(data == 0)
-	{
-	    I2C_ADC_BASE -> PIO_CODR = I2C_ADC_SCL;
-	}
-	else
-	{
-		I2C_ADC_BASE -> PIO_SODR = I2C_ADC_SCL;
-	}
+    I2cProg[I2cLen] = I2C_OP_END;
+    I2cPc       = 0;
+    I2cAckTicks = I2C_ACK_TICKS;
+    I2cRxCnt    = 0;
+    I2cRxByte   = 0;
+    I2cNack     = FALSE;
+
+    OS_SetCSemaValue(&I2cAdc_Done, 0);
+    I2C_ADC_TC_BASE->TC_SR;
+    I2C_ADC_TC_BASE->TC_IER = AT91C_TC_CPCS;
+    I2C_ADC_TC_BASE->TC_CCR = AT91C_TC_SWTRG;
+
+    if(OS_WaitCSemaTimed(&I2cAdc_Done, I2C_ADC_TMO_MS) == 0)
+    {
+        // the interrupt never finished, leave the bus idle
+        I2C_ADC_TC_BASE->TC_IDR = AT91C_TC_CPCS;
+        I2C_ADC_BASE->PIO_SODR  = I2C_ADC_SDA | I2C_ADC_SCL;
+        I2C_ADC_BASE->PIO_OER   = I2C_ADC_SDA;
+        OS_SetCSemaValue(&I2cAdc_Done, 0);
+        return(FALSE);
+    }
+
+#ifdef DEBUG_I2C_LOAD
+    t0 = OS_GetTime_Cycles() - t0;
+    Dprintf("I2C ADC: %d ticks, %d/%d cycles in IRQ\n\r", I2cIsrCount, I2cIsrCycles, t0);
+#endif
+
+    return((I2cNack == FALSE && I2cRxCnt == I2cRxNum) ? TRUE : FALSE);
 }
 
 /******************************************************************************
@@ -218,13 +389,13 @@ static void i2c_ADC_SCL_Output(int data)
 ******************************************************************************/
 static void i2c_ADC_Start(void)
 {
-	i2c_ADC_SDA_Output(1);
-	i2c_ADC_SCL_Output(1);
-	i2c_ADC_delay();
-	i2c_ADC_SDA_Output(0);
-	i2c_ADC_delay();
-	i2c_ADC_SCL_Output(0);
-    i2c_ADC_delay();
+	i2c_ADC_Op(I2C_OP_SDA_H);
+	i2c_ADC_Op(I2C_OP_SCL_H);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SDA_L);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SCL_L);
+    i2c_ADC_Op(I2C_OP_WAIT);
 }
 
 /******************************************************************************
@@ -232,16 +403,17 @@ static void i2c_ADC_Start(void)
     Form            : void i2c_Stop(void)
     Parameters      : none
     Return value    : none
-    Description     : Send stop signal.
+    Description     : Send stop signal, a missing ACK jumps to the last one.
 ******************************************************************************/
 static void i2c_ADC_Stop(void)
 {
-	i2c_ADC_SDA_Output(0);
-	i2c_ADC_delay();
-	i2c_ADC_SCL_Output(1);
-	i2c_ADC_delay();
-	i2c_ADC_SDA_Output(1);
-	i2c_ADC_delay();
+    I2cStop = I2cLen;
+	i2c_ADC_Op(I2C_OP_SDA_L);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SCL_H);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SDA_H);
+	i2c_ADC_Op(I2C_OP_WAIT);
 }
 
 /******************************************************************************
@@ -257,81 +429,57 @@ static void i2c_ADC_SendByte(unsigned char ch)
 
 	for(i = 0; i < 8; i++)
 	{
-		i2c_ADC_SDA_Output(ch & 0x80);
+		i2c_ADC_Op((ch & 0x80) ? I2C_OP_SDA_H : I2C_OP_SDA_L);
 		ch <<= 1;
-		i2c_ADC_delay();
-		i2c_ADC_SCL_Output(1);
-		i2c_ADC_delay();
-        i2c_ADC_SCL_Output(0);
-        i2c_ADC_delay();
+		i2c_ADC_Op(I2C_OP_WAIT);
+		i2c_ADC_Op(I2C_OP_SCL_H);
+		i2c_ADC_Op(I2C_OP_WAIT);
+        i2c_ADC_Op(I2C_OP_SCL_L);   // the next SDA goes out in the same tick
 	}
 }
 
 /******************************************************************************
     Routine Name    : i2c_ReceiveByte
-    Form            : void i2c_SendByte(unsigned char)
+    Form            : void i2c_ReceiveByte(void)
     Parameters      : none
-    Return value    : Recived data
-    Description     : Get data(one byte).
+    Return value    : none
+    Description     : Get data(one byte) into I2cRx[].
 ******************************************************************************/
-static unsigned char i2c_ADC_ReceiveByte(void)
+static void i2c_ADC_ReceiveByte(void)
 {
 	unsigned char i;
-	unsigned char data;
-
-	data = 0;
 
-	I2C_ADC_BASE->PIO_ODR = I2C_ADC_SDA;
+	i2c_ADC_Op(I2C_OP_SDA_IN);
 	for(i = 0; i < 8; i++)
 	{
-        data <<= 1;
-		i2c_ADC_SCL_Output(1);
-        i2c_ADC_delay();
-		data |= i2c_ADC_SDA_Input();
-        i2c_ADC_delay();
-		i2c_ADC_SCL_Output(0);
-        i2c_ADC_delay();
+		i2c_ADC_Op(I2C_OP_SCL_H);
+        i2c_ADC_Op(I2C_OP_WAIT);
+		i2c_ADC_Op(I2C_OP_BIT);     // sampled at the end of SCL high
+		i2c_ADC_Op(I2C_OP_SCL_L);
+        i2c_ADC_Op(I2C_OP_WAIT);
 	}
-	I2C_ADC_BASE->PIO_OER = I2C_ADC_SDA;
-	return data;
+	i2c_ADC_Op(I2C_OP_SDA_OUT);
+	i2c_ADC_Op(I2C_OP_SAVE);
+	I2cRxNum++;
 }
 
 /******************************************************************************
     Routine Name    : i2c_WaitAck
-    Form            : int i2c_WaitAck(void)
+    Form            : void i2c_WaitAck(void)
     Parameters      : none
-    Return value    : errer code
-    Description     : Wait for ACK.
+    Return value    : none
+    Description     : Wait for ACK, without it the transfer jumps to the stop.
 ******************************************************************************/
-static int i2c_ADC_WaitAck(void)
+static void i2c_ADC_WaitAck(void)
 {
-	unsigned int errtime;
-
-#ifdef DEBUG_IRNORE_I2C
-	errtime = 3;
-#else
-	errtime = 300000;
-#endif
-
-	I2C_ADC_BASE->PIO_ODR =  I2C_ADC_SDA;
-	i2c_ADC_delay();
-    i2c_ADC_SCL_Output(1);
-    i2c_ADC_delay();
-	while ( (I2C_ADC_BASE->PIO_PDSR & I2C_ADC_SDA ) == I2C_ADC_SDA )
-	{
-		errtime--;
-		if (!errtime)
-		{
-			I2C_ADC_BASE->PIO_OER = I2C_ADC_SDA;
-            i2c_ADC_SDA_Output(1);
-            i2c_ADC_SCL_Output(0);
-			return FALSE;
-		}
-	}
-	i2c_ADC_SCL_Output(0);
-	I2C_ADC_BASE->PIO_OER = I2C_ADC_SDA;
-    i2c_ADC_delay();
-	return TRUE;
+	i2c_ADC_Op(I2C_OP_SDA_IN);
+	i2c_ADC_Op(I2C_OP_WAIT);
+    i2c_ADC_Op(I2C_OP_SCL_H);
+    i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_ACK);
+	i2c_ADC_Op(I2C_OP_SCL_L);
+	i2c_ADC_Op(I2C_OP_SDA_OUT);
+    i2c_ADC_Op(I2C_OP_WAIT);
 }
 
 /******************************************************************************
@@ -343,14 +491,13 @@ static int i2c_ADC_WaitAck(void)
 ******************************************************************************/
 static void i2c_ADC_SendAck(void)
 {
-	i2c_ADC_SDA_Output(0);
-	i2c_ADC_delay();
-	i2c_ADC_SCL_Output(1);
-	i2c_ADC_delay();
-	i2c_ADC_delay();
-	i2c_ADC_SCL_Output(0);
-	i2c_ADC_delay();
-    i2c_ADC_SDA_Output(0);
+	i2c_ADC_Op(I2C_OP_SDA_L);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SCL_H);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SCL_L);
+	i2c_ADC_Op(I2C_OP_WAIT);
+    i2c_ADC_Op(I2C_OP_SDA_L);
 }
 
 /******************************************************************************
@@ -362,13 +509,13 @@ static void i2c_ADC_SendAck(void)
 ******************************************************************************/
 static void i2c_ADC_SendNotAck(void)
 {
-	i2c_ADC_SDA_Output(1);
-	i2c_ADC_delay();
-	i2c_ADC_SCL_Output(1);
-	i2c_ADC_delay();
-	i2c_ADC_SCL_Output(0);
-	i2c_ADC_delay();
-    i2c_ADC_SDA_Output(0);
+	i2c_ADC_Op(I2C_OP_SDA_H);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SCL_H);
+	i2c_ADC_Op(I2C_OP_WAIT);
+	i2c_ADC_Op(I2C_OP_SCL_L);
+	i2c_ADC_Op(I2C_OP_WAIT);
+    i2c_ADC_Op(I2C_OP_SDA_L);
 }
 
 //=============================================================================
@@ -392,98 +539,162 @@ static void ADC_VoltIn_100to1_ENABLE()
 
 static INT8U i2c_ADC3421_ConfigADC(unsigned char configValue)
 {
-	//INT8U i;
-    
+    INT8U status;
+
+    OS_Use(&I2cAdc_Lock);
+    i2c_ADC_Begin();
     i2c_ADC_Start();
 	i2c_ADC_SendByte( ADC3421_ADDR_W ); 
-	if(i2c_ADC_WaitAck() != TRUE)
-	{
-		i2c_ADC_Stop();
-		return  FALSE;
-	}
-
+	i2c_ADC_WaitAck();
     i2c_ADC_SendByte(configValue);		
-    if(i2c_ADC_WaitAck() != TRUE)
-	{
-		i2c_ADC_Stop();
-		return FALSE;
-	}
+    i2c_ADC_WaitAck();
 	i2c_ADC_Stop();
+    status = i2c_ADC_Run();
+    OS_Unuse(&I2cAdc_Lock);
             
-	return TRUE;
+	return status;
 }
 
 static INT8U i2c_ADC3421_readVoltage(INT8U * pVoltage, INT8U length)
 {
     INT8U i;
+    INT8U status;
+
+    if(length == 0 || length > I2C_RX_SIZE)
+    {
+        return FALSE;
+    }
 
+    OS_Use(&I2cAdc_Lock);
+    i2c_ADC_Begin();
 	i2c_ADC_Start();
 	i2c_ADC_SendByte( ADC3421_ADDR_R ); 
-	if(i2c_ADC_WaitAck() != TRUE)
-	{
-		i2c_ADC_Stop();
-		return FALSE;
-	}
+	i2c_ADC_WaitAck();
     
 	for ( i = 0; i < (length - 1); i++ )
     {
-        pVoltage[i] = i2c_ADC_ReceiveByte();		//read data
+        i2c_ADC_ReceiveByte();		//read data
         i2c_ADC_SendAck();
     }
 	
-    pVoltage[length - 1] = i2c_ADC_ReceiveByte();			//read data    
+    i2c_ADC_ReceiveByte();			//read data    
     i2c_ADC_SendNotAck();
 	i2c_ADC_Stop();
 
-	return TRUE;
-}
+    status = i2c_ADC_Run();
+    if(status == TRUE)
+    {
+        memcpy(pVoltage, I2cRx, length);
+    }
+    OS_Unuse(&I2cAdc_Lock);
 
+	return status;
+}
 
-static INT32U ADC_value_no_verify(INT32U val_range, INT32U val_precision)
+/******************************************************************************
+    Routine Name    : ADC_ReadCode
+    Form            : BOOL ADC_ReadCode(INT32U control_byte, INT32U val_precision, INT32U * pcode)
+    Parameters      : control_byte, val_precision, pcode
+    Return value    : TRUE if the ADC answered
+    Description     : Start one conversion and read its code, a negative code
+                      reads as 0.
+******************************************************************************/
+static BOOL ADC_ReadCode(INT32U control_byte, INT32U val_precision, INT32U * pcode)
 {
-    INT32U i, j, control_byte;
-    INT32U AD_DataTemp[16];
-    INT32U IDataTemp, tempVolt;
     INT8U voltArray[4] = {0};
-    INT32U status;    
     INT32U waitTimer[4] = { SRS_12BIT, SRS_14BIT, SRS_16BIT, SRS_18BIT };  //ͬľȶӦͬĵȴʱ
     INT32U AD_Limit[4] = { LIMIT_12BIT, LIMIT_14BIT, LIMIT_16BIT, LIMIT_18BIT};
+
+    if(i2c_ADC3421_ConfigADC(control_byte) != TRUE)
+        return FALSE;
+
+    //ʱ 
+    OS_Delay(waitTimer[val_precision]);
+    if(i2c_ADC3421_readVoltage(voltArray, 4) != TRUE)
+        return FALSE;
+
+    if(val_precision == PRECISION_18BIT)
+    {
+        *pcode = (voltArray[0]<<16) | (voltArray[1]<<8)  | (voltArray[2]<<0) ; 
+    }
+    else
+    {
+        *pcode =  (voltArray[0]<<8)  | (voltArray[1]<<0) ; 
+    }   
+
+    if(*pcode > AD_Limit[val_precision])
+    {
+        *pcode = 0;
+    }
+    return TRUE;
+}
+
+/******************************************************************************
+    Routine Name    : ADC_Scale
+    Form            : INT32U ADC_Scale(INT32U val_range, INT32U code, INT32U val_precision)
+    Parameters      : val_range, code, val_precision
+    Return value    : mV before calibration, 0 for a bad range
+    Description     : Convert a code to the voltage at the divider input.
+******************************************************************************/
+static INT32U ADC_Scale(INT32U val_range, INT32U code, INT32U val_precision)
+{
+    INT32U tempVolt;
+
+    if(val_range == _RANGE_0_2V) 
+    {
+        tempVolt = code;
+    }
+    else  if(val_range == _RANGE_0_20V) 
+    {
+        tempVolt =  code * 11;
+    }
+    else if(val_range == _RANGE_0_200V) 
+    {
+        tempVolt = code * 100;
+    }
+    else 
+        return 0;
+    
+    return  tempVolt * 2048 / ( (1 << (11 + 2 * val_precision) )- 1 );
+}
+
+#define AD_SAMPLES      (16)        // samples of a filtered reading, AD_MeasureWindow() may take fewer
+
+static INT32U AdSpread;     // codes between the 1/4 and 3/4 samples of the last reading
+
+/******************************************************************************
+    Routine Name    : ADC_ReadFiltered
+    Form            : INT32U ADC_ReadFiltered(INT32U val_precision, INT32U n)
+    Parameters      : val_precision
+                      n, samples, 2..AD_SAMPLES
+    Return value    : average code of the middle half of the samples, Q4
+    Description     : Filtered reading of the selected range.
+******************************************************************************/
+static INT32U ADC_ReadFiltered(INT32U val_precision, INT32U n)
+{
+    INT32U i, j, control_byte;
+    INT32U AD_DataTemp[AD_SAMPLES];
+    INT32U IDataTemp;
+    INT32U lo, hi;
     
     control_byte = (PGA_1VV | (val_precision << 2)| (INITIATE_TRANSITION << 7)); 
     // waiting for some time after change the relay status
     //Delay_ms(200); 
   
+    if(n < 2 || n > AD_SAMPLES)
+    {
+        n = AD_SAMPLES;
+    }
     //
-    for(i=0;i<16;i++)
+    for(i=0;i<n;i++)
     { 
-        status  = i2c_ADC3421_ConfigADC(control_byte);
-        if(status != TRUE)
+        if(ADC_ReadCode(control_byte, val_precision, &AD_DataTemp[i]) != TRUE)
             return 0;
-       
-        //ʱ 
-        OS_Delay(waitTimer[val_precision]);
-        status = i2c_ADC3421_readVoltage(voltArray, 4);
-        if(status != TRUE)
-            return 0;        
-        if(val_precision == PRECISION_18BIT)
-        {
-
-            AD_DataTemp[i] = (voltArray[0]<<16) | (voltArray[1]<<8)  | (voltArray[2]<<0) ; 
-        }
-        else
-        {
-            AD_DataTemp[i] =  (voltArray[0]<<8)  | (voltArray[1]<<0) ; 
-        }   
-
-        if(AD_DataTemp[i] > AD_Limit[val_precision])
-        {
-            AD_DataTemp[i] = 0;
-        }
     }    
 
-    for(j=1;j<16;j++)    // ðݷ
+    for(j=1;j<n;j++)    // ðݷ
     {        
-        for(i=0;i<(16-j);i++)
+        for(i=0;i<(n-j);i++)
         {
             if(AD_DataTemp[i]<AD_DataTemp[i+1])
             {
@@ -494,89 +705,495 @@ static INT32U ADC_value_no_verify(INT32U val_range, INT32U val_precision)
         }
     }
 
+    // average the middle half, 4~11 of 16
+    lo = n / 4;
+    hi = n - n / 4;
+    AdSpread = AD_DataTemp[lo] - AD_DataTemp[hi - 1];
+
     IDataTemp = 0;
-    for(i=4; i<12; i++)
+    for(i=lo; i<hi; i++)
         IDataTemp += AD_DataTemp[i];
 
-    IDataTemp = IDataTemp/8;
-
-    if(val_range == _RANGE_0_2V) 
-    {
-        tempVolt = IDataTemp;
-    }
-    else  if(val_range == _RANGE_0_20V) 
-    {
-        tempVolt =  IDataTemp * 11;
-    }
-    else if(val_range == _RANGE_0_200V) 
-    {
-        tempVolt = IDataTemp * 100;
-    }
-    else 
-        return 0;
-    
-    return  tempVolt * 2048 / ( (1 << (11 + 2 * val_precision) )- 1 );
+    return (IDataTemp << AD_CODE_Q) / (hi - lo);
 }
 
-
-INT32U ADC_cal_value(INT32U val_range, INT32U val_precision)
+/******************************************************************************
+    Routine Name    : ADC_SelectRange
+    Form            : BOOL ADC_SelectRange(INT32U val_range)
+    Parameters      : val_range
+    Return value    : FALSE for a bad range
+    Description     : Switch the divider relays to a range.
+******************************************************************************/
+static BOOL ADC_SelectRange(INT32U val_range)
 {
-    float verify_coef_factor = 0;
-    INT32U voltage = 0;
     switch(val_range)
     {
         case _RANGE_0_2V:
-            verify_coef_factor = verify_coef_range_1to1;
             // small range
             ADC_VoltIn_1to1_ENABLE();
-            break;
+            return TRUE;
 
         case _RANGE_0_20V:
-            verify_coef_factor = verify_coef_range_10to1;
             // middle range
             ADC_VoltIn_10to1_ENABLE();
-            break;   
+            return TRUE;
         
         case _RANGE_0_200V:
-            verify_coef_factor = verify_coef_range_100to1; 
             // large range
             ADC_VoltIn_100to1_ENABLE();
-            break;             
+            return TRUE;
             
         default:
-            return 0;
+            return FALSE;
     }
-    
-    voltage = (INT32U)(ADC_value_no_verify(val_range, val_precision) * verify_coef_factor); 
-    return  voltage; 
 }
 
-INT32U AD_MeasureAutoRange(INT32U VoltMax)
+/*
+    Range selection of AD_MeasureChannel(). The limit of the item gives the
+    range the old code used; the last value read on the same channel may
+    allow a finer one. A guessed range is checked with one 12 bit conversion
+    (5ms) before the slow reading, and a saturated reading moves one range up.
+    The fixture resets after every DUT, so the history, with the noise the
+    resolution policy uses, is kept in AdHist.bin:
+    read by AD_HistInit() at power on and written by AD_HistSave() after the
+    DUT, so the first reading of a channel uses what the last DUT showed.
+*/
+#define AD_FULL_SCALE_2V        (2048)
+#define AD_RANGE_FIT(v, fs)     ((v) <= (fs) * 7 / 8)       // 1/8 headroom
+#define AD_SATURATED(v, fs)     ((v) >= (fs) * 31 / 32)
+
+#define AD_HIST_MAGIC           (0x32484441)    // "ADH2"
+
+static INT32U AdLastVolt[AD_CHN_MAX];
+static INT8U  AdLastRange[AD_CHN_MAX];      // 0: never measured
+static INT32U AdNoiseUv[AD_CHN_MAX];        // spread of the middle half of the samples, uV
+static INT8U  AdNoisePrec[AD_CHN_MAX];      // precision the spread was read at, +1
+static BOOL   AdHistDirty = FALSE;
+
+static void AD_HistClear(void)
 {
-    INT32U volt;
-    float verify_coef_factor = 0;
+    memset(AdLastVolt, 0, sizeof(AdLastVolt));
+    memset(AdLastRange, 0, sizeof(AdLastRange));
+    memset(AdNoiseUv, 0, sizeof(AdNoiseUv));
+    memset(AdNoisePrec, 0, sizeof(AdNoisePrec));
+}
+
+/******************************************************************************
+    Routine Name    : AD_HistInit
+    Form            : void AD_HistInit(void)
+    Parameters      : none
+    Return value    : none
+    Description     : Read the channel history and noise of the fixture.
+******************************************************************************/
+void AD_HistInit(void)
+{
+    FS_FILE *fb;
+    U32 magic = 0;
+
+    AD_HistClear();
+    if(fb = FS_FOpen(AD_HIST_FILE,"rb"))
+    {
+        FS_FRead(&magic, sizeof(magic), 1, fb);
+        if(magic != AD_HIST_MAGIC
+            || FS_FRead(AdLastVolt, sizeof(AdLastVolt), 1, fb) != 1
+            || FS_FRead(AdLastRange, sizeof(AdLastRange), 1, fb) != 1
+            || FS_FRead(AdNoiseUv, sizeof(AdNoiseUv), 1, fb) != 1
+            || FS_FRead(AdNoisePrec, sizeof(AdNoisePrec), 1, fb) != 1)
+        {
+            AD_HistClear();
+        }
+        FS_FClose(fb);
+    }
+    AdHistDirty = FALSE;
+}
+
+/******************************************************************************
+    Routine Name    : AD_HistSave
+    Form            : void AD_HistSave(void)
+    Parameters      : none
+    Return value    : none
+    Description     : Save the channel history when a channel was measured.
+******************************************************************************/
+void AD_HistSave(void)
+{
+    FS_FILE *fb;
+    U32 magic = AD_HIST_MAGIC;
+
+    if(AdHistDirty == FALSE)
+    {
+        return;
+    }
+
+    if(fb = FS_FOpen(AD_HIST_FILE,"wb"))
+    {
+        FS_FWrite(&magic, sizeof(magic), 1, fb);
+        FS_FWrite(AdLastVolt, sizeof(AdLastVolt), 1, fb);
+        FS_FWrite(AdLastRange, sizeof(AdLastRange), 1, fb);
+        FS_FWrite(AdNoiseUv, sizeof(AdNoiseUv), 1, fb);
+        FS_FWrite(AdNoisePrec, sizeof(AdNoisePrec), 1, fb);
+        FS_SetEndOfFile(fb);
+        FS_FClose(fb);
+        AdHistDirty = FALSE;
+    }
+}
+
+static INT32U AD_FullScale(INT32U val_range)
+{
+    if(val_range == _RANGE_0_200V)
+        return AD_FULL_SCALE_2V * 100;
+    if(val_range == _RANGE_0_20V)
+        return AD_FULL_SCALE_2V * 11;
+    return AD_FULL_SCALE_2V;
+}
+
+static INT32U AD_RangeFor(INT32U volt)
+{
+	if(volt > 20000)
+        return _RANGE_0_200V;
+	if(volt > 2000)
+        return _RANGE_0_20V;
+    return _RANGE_0_2V;
+}
+
+static INT64U AD_NomMul(INT32U val_range, INT32U val_precision)
+{
+    return ((INT64U)AD_FullScale(val_range) * 1000 << AD_MUL_Q) / ((1 << (11 + 2 * val_precision)) - 1);
+}
+
+static void AD_CalBuild(INT32U val_range)
+{
+    INT32U p;
+
+    for(p = PRECISION_12BIT; p <= PRECISION_18BIT; p++)
+    {
+        if(AD_CalActive(val_range))     // the table replaces the gain
+        {
+            AdMul[val_range - 1][p] = AD_NomMul(val_range, p);
+        }
+        else
+        {
+            AdMul[val_range - 1][p] = AD_NomMul(val_range, p) * AdGainPpm[val_range - 1] / AD_GAIN_UNITY;
+        }
+    }
+}
+
+/******************************************************************************
+    Routine Name    : AD_SetCal
+    Form            : void AD_SetCal(INT32U val_range, INT32U gain_ppm, S32 offset_uv)
+    Parameters      : val_range, _RANGE_0_xxV
+                      gain_ppm, AD_GAIN_UNITY for no correction
+                      offset_uv, added after the gain
+    Return value    : none
+    Description     : Set the calibration of a range, it works at once.
+******************************************************************************/
+void AD_SetCal(INT32U val_range, INT32U gain_ppm, S32 offset_uv)
+{
+    if(val_range < _RANGE_0_2V || val_range > _RANGE_0_200V || gain_ppm == 0)
+    {
+        return;
+    }
+    AdGainPpm[val_range - 1] = gain_ppm;
+    AdOfsUv[val_range - 1]   = offset_uv;
+    AD_CalBuild(val_range);
+}
+
+void AD_GetCal(INT32U val_range, INT32U * pgain_ppm, S32 * poffset_uv)
+{
+    if(val_range < _RANGE_0_2V || val_range > _RANGE_0_200V)
+    {
+        return;
+    }
+    *pgain_ppm  = AdGainPpm[val_range - 1];
+    *poffset_uv = AdOfsUv[val_range - 1];
+}
+
+/******************************************************************************
+    Routine Name    : ADC_CalUv
+    Form            : INT32U ADC_CalUv(INT32U val_range, INT32U code, INT32U val_precision)
+    Parameters      : val_range, code (Q4), val_precision
+    Return value    : calibrated uV at the divider input
+    Description     : The only conversion of a reading to a voltage, with
+                      the table of AD_Cal.c when the range has one.
+******************************************************************************/
+static INT32U ADC_CalUv(INT32U val_range, INT32U code, INT32U val_precision)
+{
+    S64 uv;
+
+    uv = (S64)(((INT64U)code * AdMul[val_range - 1][val_precision]) >> (AD_MUL_Q + AD_CODE_Q));
+    if(AD_CalActive(val_range))
+    {
+        return AD_CalApply(val_range, (INT32U)uv);
+    }
+    uv += AdOfsUv[val_range - 1];
+
+    return (uv > 0) ? (INT32U)uv : 0;
+}
+
+/******************************************************************************
+    Routine Name    : AD_ReadRawUv
+    Form            : INT32U AD_ReadRawUv(INT32U val_range, INT32U val_precision)
+    Parameters      : val_range, val_precision
+    Return value    : uV without any calibration
+    Description     : Filtered reading of a range for AD_CalAddPoint().
+******************************************************************************/
+INT32U AD_ReadRawUv(INT32U val_range, INT32U val_precision)
+{
+    if(ADC_SelectRange(val_range) == FALSE)
+    {
+        return 0;
+    }
+    return (INT32U)(((INT64U)ADC_ReadFiltered(val_precision, AD_SAMPLES) * AD_NomMul(val_range, val_precision)) >> (AD_MUL_Q + AD_CODE_Q));
+}
+
+INT32U ADC_cal_value(INT32U val_range, INT32U val_precision)
+{
+    if(ADC_SelectRange(val_range) == FALSE)
+    {
+        return 0;
+    }
     
-	if(VoltMax > 20000)
-	{
-        ADC_VoltIn_100to1_ENABLE();
-        verify_coef_factor = verify_coef_range_100to1; 
-		volt = ADC_value_no_verify(_RANGE_0_200V, PRECISION_12BIT);
-	}
-	else if(VoltMax > 2000)
-	{
-        ADC_VoltIn_10to1_ENABLE();
-        verify_coef_factor = verify_coef_range_10to1; 
-		volt = ADC_value_no_verify(_RANGE_0_20V, PRECISION_12BIT);
-	}
-	else
-	{
-        ADC_VoltIn_1to1_ENABLE();
-        verify_coef_factor = verify_coef_range_1to1; 
-		volt = ADC_value_no_verify(_RANGE_0_2V, PRECISION_12BIT);
-	}
-//    Dprintf("voltage is %d\n\r", volt);
+    return (ADC_CalUv(val_range, ADC_ReadFiltered(val_precision, AD_SAMPLES), val_precision) + 500) / 1000; 
+}
+
+/******************************************************************************
+    Routine Name    : AD_CodeToUv
+    Form            : INT32U AD_CodeToUv(INT32U val_range, INT32U code, INT32U val_precision)
+    Parameters      : val_range, code, val_precision
+    Return value    : uV at the divider input
+    Description     : Like ADC_Scale(), for a size of some codes.
+******************************************************************************/
+static INT32U AD_CodeToUv(INT32U val_range, INT32U code, INT32U val_precision)
+{
+    return (INT32U)((INT64U)code * AD_FullScale(val_range) * 1000 / ( (1 << (11 + 2 * val_precision) )- 1 ));
+}
+
+/******************************************************************************
+    Routine Name    : AD_GuessRange
+    Form            : INT32U AD_GuessRange(INT32U chn, INT32U VoltMax, BOOL * pprobe)
+    Parameters      : chn, VoltMax, pprobe
+    Return value    : the range to start with
+    Description     : *pprobe is set when the range is only a guess.
+******************************************************************************/
+static INT32U AD_GuessRange(INT32U chn, INT32U VoltMax, BOOL * pprobe)
+{
+    INT32U val_range, guess;
+
+    *pprobe = FALSE;
+    val_range = VoltMax ? AD_RangeFor(VoltMax) : _RANGE_0_20V;
+
+    if(chn < AD_CHN_MAX && AdLastRange[chn])
+    {
+        guess = AD_RangeFor(AdLastVolt[chn] * 5 / 4);
+        if(VoltMax == 0 || guess < val_range)
+        {
+            val_range = guess;
+            *pprobe = TRUE;
+        }
+    }
+    else if(VoltMax == 0)
+    {
+        *pprobe = TRUE;
+    }
+    return val_range;
+}
+
+/******************************************************************************
+    Routine Name    : AD_PlanRange
+    Form            : INT32U AD_PlanRange(INT32U chn, INT32U VoltMax, BOOL select)
+    Parameters      : chn, VoltMax, as AD_MeasureUv
+                      select, switch the divider relays to it now
+    Return value    : the range the next reading of the channel starts with
+    Description     : Lets a scan order its points by range and switch the
+                      range while the input relay settles.
+******************************************************************************/
+INT32U AD_PlanRange(INT32U chn, INT32U VoltMax, BOOL select)
+{
+    INT32U val_range;
+    BOOL probe;
+
+    val_range = AD_GuessRange(chn, VoltMax, &probe);
+    if(select)
+    {
+        ADC_SelectRange(val_range);
+    }
+    return val_range;
+}
+
+/******************************************************************************
+    Routine Name    : AD_ProbeRange
+    Form            : INT32U AD_ProbeRange(INT32U val_range)
+    Parameters      : val_range, the guess
+    Return value    : the finest range that holds the input
+    Description     : Pick the range with single 12 bit conversions.
+******************************************************************************/
+static INT32U AD_ProbeRange(INT32U val_range)
+{
+    INT32U code, volt;
+    INT32U control_byte = (PGA_1VV | (PRECISION_12BIT << 2)| (INITIATE_TRANSITION << 7));
+
+    for(;;)
+    {
+        ADC_SelectRange(val_range);
+        if(ADC_ReadCode(control_byte, PRECISION_12BIT, &code) != TRUE)
+        {
+            return val_range;
+        }
+        volt = ADC_Scale(val_range, code, PRECISION_12BIT);
+
+        if(AD_SATURATED(volt, AD_FullScale(val_range)) && val_range < _RANGE_0_200V)
+        {
+            val_range++;
+        }
+        else
+        {
+            // going down never needs a second look
+            while(val_range > _RANGE_0_2V && AD_RANGE_FIT(volt, AD_FullScale(val_range - 1)))
+            {
+                val_range--;
+            }
+            return val_range;
+        }
+    }
+}
+
+/******************************************************************************
+    Routine Name    : AD_ReadChannelUv
+    Form            : INT32U AD_ReadChannelUv(INT32U chn, INT32U VoltMax, INT32U val_precision, INT32U samples)
+    Parameters      : chn, VoltMax, val_precision, as AD_MeasureUv
+                      samples, of the filtered reading
+    Return value    : uV
+    Description     : Measure with the finest range that holds the input.
+******************************************************************************/
+static INT32U AD_ReadChannelUv(INT32U chn, INT32U VoltMax, INT32U val_precision, INT32U samples)
+{
+    INT32U val_range, code, uv;
+    BOOL probe;
+
+    val_range = AD_GuessRange(chn, VoltMax, &probe);
+
+    // a slow reading on a wrong range costs far more than the probe
+    if(probe && val_precision > PRECISION_12BIT)
+    {
+        val_range = AD_ProbeRange(val_range);
+    }
+
+    for(;;)
+    {
+        ADC_SelectRange(val_range);
+        code = ADC_ReadFiltered(val_precision, samples);
+        if(AD_SATURATED(code, AdLimit[val_precision] << AD_CODE_Q) == FALSE || val_range == _RANGE_0_200V)
+        {
+            break;
+        }
+        val_range++;
+    }
+    uv = ADC_CalUv(val_range, code, val_precision);
+
+    if(chn < AD_CHN_MAX)
+    {
+        AdLastVolt[chn]  = uv / 1000;
+        AdLastRange[chn] = (INT8U)val_range;
+        AdNoiseUv[chn]   = AD_CodeToUv(val_range, AdSpread, val_precision);
+        AdNoisePrec[chn] = (INT8U)(val_precision + 1);
+        AdHistDirty      = TRUE;
+    }
+//    Dprintf("voltage is %d\n\r", uv);
 	
-	return((INT32U)(volt * verify_coef_factor));
+	return(uv);
+}
+
+/******************************************************************************
+    Routine Name    : AD_MeasureUv
+    Form            : INT32U AD_MeasureUv(INT32U chn, INT32U VoltMax, INT32U val_precision)
+    Parameters      : chn, relay channel of the input, AD_CHN_NONE if unknown
+                      VoltMax, upper limit in mV, 0 if unknown
+                      val_precision, PRECISION_xxBIT of the reading
+    Return value    : uV
+    Description     : Measure with the finest range that holds the input,
+                      AD_SAMPLES samples at any precision.
+******************************************************************************/
+INT32U AD_MeasureUv(INT32U chn, INT32U VoltMax, INT32U val_precision)
+{
+    return(AD_ReadChannelUv(chn, VoltMax, val_precision, AD_SAMPLES));
+}
+
+INT32U AD_MeasureChannel(INT32U chn, INT32U VoltMax, INT32U val_precision)
+{
+    return((AD_MeasureUv(chn, VoltMax, val_precision) + 500) / 1000);
+}
+
+INT32U AD_MeasureAutoRange(INT32U VoltMax)
+{
+    return(AD_MeasureChannel(AD_CHN_NONE, VoltMax, PRECISION_12BIT));
+}
+
+/*
+    Resolution policy of AD_MeasureWindow(). Every 2 bits of precision make a
+    conversion 4 times slower (5ms to 300ms, x16 samples), so the lowest
+    precision is used that puts AD_WINDOW_CODES codes across the limit window
+    and keeps the spread last seen on the channel under 1/AD_WINDOW_NOISE of
+    it. The spread of a slower conversion is taken as half per 2 bits, and
+    only this path takes fewer samples of it (16 at 12 bit, 2 at 18); the
+    calibration and the other readings keep AD_SAMPLES.
+*/
+#define AD_WINDOW_CODES     (32)
+#define AD_WINDOW_NOISE     (4)
+
+static const INT32U AdWindowSamples[4] = { 16, 8, 4, 2 };    // a slower conversion already averages more
+
+static INT32U AD_PickPrecision(INT32U chn, INT32U val_range, INT32U window)
+{
+    INT32U p, q, noise;
+    INT32U windowUv = window * 1000;
+
+    for(p = PRECISION_12BIT; p < PRECISION_18BIT; p++)
+    {
+        if(AD_CodeToUv(val_range, AD_WINDOW_CODES, p) > windowUv)
+        {
+            continue;
+        }
+        if(chn < AD_CHN_MAX && AdNoisePrec[chn])
+        {
+            q = AdNoisePrec[chn] - 1;
+            noise = (p >= q) ? (AdNoiseUv[chn] >> (p - q)) : (AdNoiseUv[chn] << (q - p));
+            if(noise * AD_WINDOW_NOISE > windowUv)
+            {
+                continue;
+            }
+        }
+        break;
+    }
+    return p;
+}
+
+/******************************************************************************
+    Routine Name    : AD_MeasureWindow
+    Form            : INT32U AD_MeasureWindow(INT32U chn, INT32U lower, INT32U upper, INT32U bits)
+    Parameters      : chn, relay channel of the input
+                      lower, upper, limits in mV
+                      bits, 12/14/16/18 to force the resolution, 0 for the policy
+    Return value    : mV
+    Description     : Measure with the lowest resolution the limits need.
+******************************************************************************/
+INT32U AD_MeasureWindow(INT32U chn, INT32U lower, INT32U upper, INT32U bits)
+{
+    INT32U val_precision;
+    BOOL probe;
+
+    if(bits >= 12 && bits <= 18)
+    {
+        val_precision = (bits - 12) / 2;
+    }
+    else if(upper > lower)
+    {
+        val_precision = AD_PickPrecision(chn, AD_GuessRange(chn, upper, &probe), upper - lower);
+    }
+    else
+    {
+        val_precision = PRECISION_12BIT;
+    }
+
+    return((AD_ReadChannelUv(chn, upper, val_precision, AdWindowSamples[val_precision]) + 500) / 1000);
 }
 
 INT32U ADC_value_18Bit(INT32U val_range, INT32U Gain, INT32U val_precision)
@@ -674,7 +1291,7 @@ INT32U ADC_Test(void)
 {  
     INT32U volt;
     
-    i2c_ADC_init(1.0001, 1.0002, 1.0003);  
+    i2c_ADC_init();  
     
     while(1)
     {
@@ -709,22 +1326,14 @@ INT32U ADC_Test(void)
 //gaoxi add to get AD value direct from chip, without edge-based line averaging 
 INT32S Fast_AD_cal_value(INT32U val_range)
 {
-    INT32S IDataTemp;
-	INT32U control_byte;
-/*    
-    IDataTemp = ADConvert(control_byte); // unipolar
-    _RANGE_LARGE();
-    
-    if((val_range == _RANGE_S_0_4V) || (val_range == _RANGE_S_N2_P2))
-    {
-        return (INT32S)(IDataTemp * verify_coef_range_s);
-    }
-    else
+    INT32U code;
+	INT32U control_byte = (PGA_1VV | (PRECISION_12BIT << 2)| (INITIATE_TRANSITION << 7));
+
+    if(ADC_SelectRange(val_range) == FALSE || ADC_ReadCode(control_byte, PRECISION_12BIT, &code) != TRUE)
     {
-        return (INT32S)(IDataTemp * verify_coef_range_l * 10);
+        return 0;
     }
-*/
-        return (INT32S)(IDataTemp * verify_coef_range_s);
+    return (INT32S)((ADC_CalUv(val_range, code << AD_CODE_Q, PRECISION_12BIT) + 500) / 1000);
 }
 
 // һѹвҵƽһ
@@ -735,20 +1344,20 @@ U32 VolFlashJudge(U32 *voltData, U8 judgeType, U32 lowerThreshold, U32 upperThre
     U8 judgeState = STATE_START;
     U32 result = FALSE;
     
-    //ѹһ
+    //ѹһ, ͬһж
     for(i = 0; i < MAX_COLLECT_OBJ; i++)
     {
-        if (voltData[i] < lowerThreshold)
+        switch(Stat_Classify((S32)voltData[i], (S32)lowerThreshold, (S32)upperThreshold))
         {
-            normalizVolt[i] = VOLTLOW;
-        }
-        else if (voltData[i] > upperThreshold)
-        {
-            normalizVolt[i] = VOLTHIGH;
-        }
-        else
-        {
-            normalizVolt[i] = VOLTMID;       //쳣
+            case STAT_BELOW:
+                normalizVolt[i] = VOLTLOW;
+                break;
+            case STAT_ABOVE:
+                normalizVolt[i] = VOLTHIGH;
+                break;
+            default:
+                normalizVolt[i] = VOLTMID;       //쳣
+                break;
         }
     }
     
@@ -35,13 +35,31 @@
 #define     _RANGE_0_20V        2 // 0 ~20v
 #define     _RANGE_0_200V       3 // 0 ~200v
 
+//AD_MeasureChannel ͨ, סÿͨϴε
+#define AD_CHN_MAX      (256)
+#define AD_CHN_NONE     (0xFFFF)
+#define AD_HIST_FILE    "AdHist.bin"
+
+//AD У׼:  ppm, ƫ uV
+#define AD_RANGE_NUM    (3)
+#define AD_GAIN_UNITY   (1000000)
+
 /*******************************************************************************
     API functions
 *******************************************************************************/
-extern void i2c_ADC_init(float coef_range_1to1, float coef_range_10to1, float coef_range_100to1);
+extern void i2c_ADC_init(void);
+extern void AD_SetCal(INT32U val_range, INT32U gain_ppm, S32 offset_uv);
+extern void AD_GetCal(INT32U val_range, INT32U * pgain_ppm, S32 * poffset_uv);
+extern INT32U AD_ReadRawUv(INT32U val_range, INT32U val_precision);
 extern INT32U ADC_cal_value(INT32U val_range, INT32U val_precision);
 extern INT32U ADC_Test(void);
 extern INT32U AD_MeasureAutoRange(INT32U VoltMax);
+extern INT32U AD_MeasureChannel(INT32U chn, INT32U VoltMax, INT32U val_precision);
+extern INT32U AD_MeasureUv(INT32U chn, INT32U VoltMax, INT32U val_precision);
+extern INT32U AD_MeasureWindow(INT32U chn, INT32U lower, INT32U upper, INT32U bits);
+extern INT32U AD_PlanRange(INT32U chn, INT32U VoltMax, BOOL select);
+extern void AD_HistInit(void);
+extern void AD_HistSave(void);
 
 #endif	/* _I2C_API_H_ */
 
@@ -0,0 +1,203 @@
+/******************************************************************************
+    Wave.c
+    High-rate waveform capture with the SAM9260 ADC
+
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+
+    The MCP3421 needs 5ms a conversion, too slow to see an LED blink. Here
+    TC3 toggles TIOA3 at the sample rate, every rising edge starts one
+    conversion of the on-chip ADC, and the PDC moves the results to RAM,
+    so 1000 samples at 100us take 100ms and no CPU. The caches are not
+    enabled in this project, the buffer needs no maintenance.
+******************************************************************************/
+#include "includes.h"
+
+#define WAVE_TC_BASE        AT91C_BASE_TC3
+#define WAVE_TC_ID          AT91C_ID_TC3
+#define WAVE_MCK_KHZ        (100000)            // nominal MCK, as the other TC users
+#define WAVE_TC_RC_MAX      (0xFFFF)            // RC is 16 bits
+#define WAVE_ADC_PRESCAL    (9)                 // ADCClock = MCK/((9+1)*2) = 5MHz
+#define WAVE_CODE_MAX       (1023)
+
+/******************************************************************************
+    Routine Name    : WAVE_Capture
+    Parameters      : chn, ADC channel 0~3
+                      period_us, sample period
+                      num, samples, WAVE_SAMPLES_MAX at most
+                      mv, buffer of num samples
+    Return value    : TRUE if all samples were taken
+    Description     : Capture num samples and convert them to mV. The TC
+                      clock is the fastest of MCK/2, /8, /32, /128 whose RC
+                      still holds the period.
+******************************************************************************/
+BOOL WAVE_Capture(U32 chn, U32 period_us, U32 num, U16 * mv)
+{
+    static const U32 tcDiv[4] = {2, 8, 32, 128};
+    U32 i, tmo, ticks = 0;
+    BOOL res;
+
+    if(chn > 3 || num == 0 || num > WAVE_SAMPLES_MAX || period_us < WAVE_PERIOD_MIN || period_us > WAVE_PERIOD_MAX)
+    {
+        return(FALSE);
+    }
+
+    for(i = 0; i < 4; i++)  // TIMER_CLOCK1..4
+    {
+        ticks = period_us * (WAVE_MCK_KHZ / tcDiv[i]) / 1000;
+        if(ticks <= WAVE_TC_RC_MAX)
+        {
+            break;
+        }
+    }
+    if(i == 4)
+    {
+        return(FALSE);
+    }
+
+    AT91C_BASE_PMC->PMC_PCER = (1 << AT91C_ID_ADC) | (1 << WAVE_TC_ID);
+
+    // the ADC input is its peripheral function, the PIO must let go of it
+    AT91C_BASE_PIOC->PIO_ODR = 1 << chn;
+    AT91C_BASE_PIOC->PIO_PPUDR = 1 << chn;
+
+    AT91C_BASE_ADC->ADC_CR   = AT91C_ADC_SWRST;
+    AT91C_BASE_ADC->ADC_MR   = AT91C_ADC_TRGEN_EN | AT91C_ADC_TRGSEL_TIOA3 | AT91C_ADC_LOWRES_10_BIT
+                             | (WAVE_ADC_PRESCAL << 8) | (4 << 16) | (2 << 24);
+    AT91C_BASE_ADC->ADC_CHDR = 0xFF;
+    AT91C_BASE_ADC->ADC_CHER = 1 << chn;
+
+    AT91C_BASE_ADC->ADC_PTCR = AT91C_PDC_RXTDIS;
+    AT91C_BASE_ADC->ADC_RPR  = (U32)mv;
+    AT91C_BASE_ADC->ADC_RCR  = num;
+    AT91C_BASE_ADC->ADC_RNCR = 0;
+    AT91C_BASE_ADC->ADC_PTCR = AT91C_PDC_RXTEN;
+
+    // TIOA3: cleared on RA, set on RC, one rising edge a period
+    WAVE_TC_BASE->TC_CCR = AT91C_TC_CLKDIS;
+    WAVE_TC_BASE->TC_IDR = 0xFFFFFFFF;
+    WAVE_TC_BASE->TC_CMR = i | AT91C_TC_WAVE | AT91C_TC_WAVESEL_UP_AUTO     // TCCLKS = i
+                         | AT91C_TC_ACPA_CLEAR | AT91C_TC_ACPC_SET;
+    WAVE_TC_BASE->TC_RC  = ticks;
+    WAVE_TC_BASE->TC_RA  = ticks / 2;
+    WAVE_TC_BASE->TC_CCR = AT91C_TC_CLKEN | AT91C_TC_SWTRG;
+
+    tmo = num * period_us / 1000 + 10;
+    while(tmo-- && (AT91C_BASE_ADC->ADC_SR & AT91C_ADC_ENDRX) == 0)
+    {
+        OS_Delay(1);
+    }
+    res = (AT91C_BASE_ADC->ADC_SR & AT91C_ADC_ENDRX) ? TRUE : FALSE;
+
+    WAVE_TC_BASE->TC_CCR = AT91C_TC_CLKDIS;
+    AT91C_BASE_ADC->ADC_PTCR = AT91C_PDC_RXTDIS;
+    AT91C_BASE_ADC->ADC_CHDR = 0xFF;
+
+    for(i = 0; i < num; i++)
+    {
+        mv[i] = (U16)((mv[i] & WAVE_CODE_MAX) * WAVE_MV_FULL / WAVE_CODE_MAX);
+    }
+    return(res);
+}
+
+/******************************************************************************
+    Routine Name    : WAVE_Analyse
+    Parameters      : mv, num, period_us, the capture
+                      lower, upper, mV, below lower is low and above upper is
+                      high, between them the level does not change. 0, 0 puts
+                      them at 40% and 60% of the swing.
+                      info, the result
+    Return value    : none
+    Description     : Count the edges, measure the period and duty.
+******************************************************************************/
+void WAVE_Analyse(U16 * mv, U32 num, U32 period_us, U32 lower, U32 upper, P_WAVE_INFO info)
+{
+    U32 i, level, swing;
+    U32 firstRise = 0, lastRise = 0;
+    U32 high = 0, known = 0;
+
+    memset(info, 0, sizeof(WAVE_INFO));
+    if(num == 0)
+    {
+        return;
+    }
+
+    info->min = info->max = mv[0];
+    for(i = 1; i < num; i++)
+    {
+        if(mv[i] < info->min)
+        {
+            info->min = mv[i];
+        }
+        if(mv[i] > info->max)
+        {
+            info->max = mv[i];
+        }
+    }
+    if(lower == 0 && upper == 0)
+    {
+        swing = info->max - info->min;
+        lower = info->min + swing * 2 / 5;
+        upper = info->min + swing * 3 / 5;
+    }
+
+    level = 2;                          // 2: not known yet
+    for(i = 0; i < num; i++)
+    {
+        if(mv[i] > upper && level != 1)
+        {
+            if(level == 0)
+            {
+                if(info->rise++ == 0)
+                {
+                    firstRise = i;
+                }
+                lastRise = i;
+            }
+            level = 1;
+        }
+        else if(mv[i] < lower && level != 0)
+        {
+            if(level == 1)
+            {
+                info->fall++;
+            }
+            level = 0;
+        }
+
+        if(level != 2)
+        {
+            known++;
+            high += level;
+        }
+    }
+
+    if(info->rise >= 2)
+    {
+        // whole periods only, from the first to the last rising edge
+        high = 0;
+        level = 1;
+        for(i = firstRise; i < lastRise; i++)
+        {
+            if(mv[i] > upper)
+            {
+                level = 1;
+            }
+            else if(mv[i] < lower)
+            {
+                level = 0;
+            }
+            high += level;
+        }
+        info->period_us = (lastRise - firstRise) * period_us / (info->rise - 1);
+        info->duty = high * 100 / (lastRise - firstRise);
+    }
+    else if(known)
+    {
+        info->duty = high * 100 / known;
+    }
+}
@@ -0,0 +1,40 @@
+/*****************************************************************************
+    Wave.h
+    High-rate waveform capture with the SAM9260 ADC
+
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+******************************************************************************/
+
+#ifndef _WAVE_H_
+#define _WAVE_H_
+
+#include "includes.h"
+
+#define WAVE_ADC_CHN        (0)         // AD0 (PC0), the LED sense input
+#define WAVE_MV_FULL        (3300)      // mV at the input for code 1023, ADVREF x divider
+#define WAVE_SAMPLES_MAX    (1000)
+#define WAVE_PERIOD_MIN     (10)        // us, the ADC needs about 3us a sample
+#define WAVE_PERIOD_MAX     (80000)     // us, 16-bit RC at MCK/128
+
+typedef struct
+{
+    U32 rise;                           // rising edges
+    U32 fall;                           // falling edges
+    U32 period_us;                      // mean rising to rising, 0 if < 2 rising edges
+    U32 duty;                           // high time, %
+    U32 min;                            // mV
+    U32 max;                            // mV
+
+} WAVE_INFO, * P_WAVE_INFO;
+
+extern BOOL WAVE_Capture(U32 chn, U32 period_us, U32 num, U16 * mv);
+extern void WAVE_Analyse(U16 * mv, U32 num, U32 period_us, U32 lower, U32 upper, P_WAVE_INFO info);
+
+#endif
+
+/*********************************** EOF **************************************/
@@ -2,6 +2,19 @@
 #ifndef _HONEYWELL_FCT_AUDIO_H_
 #define _HONEYWELL_FCT_AUDIO_H_
 
+#define AUDIO_SWEEP_MAX     16
+#define AUDIO_MASK_FILE     "AudMask.csv"   //ɨƵ: "freq_Hz[,lower_mV,upper_mV]"
+
+typedef struct
+{
+    U16 freq;       //Hz
+    U16 lower;      //ֵ mV
+    U16 upper;      //ֵ mV
+    U16 amp;        //÷ֵ mV, 0Ϊδ
+    U16 lock_ms;    //ʱ
+
+} AUDIO_PT, * P_AUDIO_PT;
+
 extern BOOL Audio_TestBuzz(U16 buzz_freq, U16 amp_lower, U16 amp_upper);
 extern BOOL Audio_LoopTest(U16 tx_amp, U16 amp_lower, U16 amp_upper);
 extern BOOL Audio_GenTone(U16 tx_fre, U16 tx_amp);
@@ -9,5 +22,8 @@ extern BOOL Audio_StopTone(void);
 extern BOOL Audio_CompToneAmp(U16 amp_lower, U16 amp_upper);
 extern BOOL Audio_DecToneFreq(U16 freq_lower, U16 freq_upper);
 extern BOOL Audio_Open(void);
+extern U32  Audio_LoadMask(P_AUDIO_PT pts, U32 max, U16 def_lower, U16 def_upper);
+extern BOOL Audio_Sweep(P_AUDIO_PT pts, U32 num, U16 tx_amp);
+extern BOOL Audio_SendDTMF(U8 * digits, U16 sig_ms, U16 spac_ms);
 #endif
 
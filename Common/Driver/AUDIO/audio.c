@@ -23,6 +23,13 @@
 #define DISC_LIMIT          3
 #define SNR_LIMIT           40
 
+#define AUDIO_POLL_MS       100     //
+#define AUDIO_LOCK_K        3       //KڷΧPASS
+#define AUDIO_LOCK_TMO_MS   4500    //ȴ, ԭ2000+5*500
+#define AUDIO_SWEEP_TMO_MS  1500    //ɨƵÿȴ
+#define AUDIO_MASK_SIZE     512
+#define AUDIO_DTMF_TAIL_MS  50      //һֺDUTʱ
+
 #define AUDFUNC_ENTER_MODE  0x51 
 #define AUDFUNC_AUD_GEN     0x52 
 #define AUDFUNC_CONFIG_SET  0x53 
@@ -68,9 +75,9 @@ static BOOL Audio_ConfigTone(U16 amp_min)
 
 static BOOL Audio_ConfigDTMF(U16 sig_time, U16 spac_time)
 {
-    U8 time_str[9];
+    U8 time_str[12];
     
-    sprintf((char * )time_str, "%d,%d", sig_time, spac_time);
+    snprintf((char * )time_str, sizeof(time_str), "%d,%d", sig_time, spac_time);
 
     return(Audio_WriteCmd(AUDFUNC_CONFIG_SET, AUDREG_CFG_DTMF, time_str));
 }
@@ -85,9 +92,9 @@ static BOOL Audio_ConfigDTMF(U16 sig_time, U16 spac_time)
 ******************************************************************************/
 static BOOL Audio_GenSimpTone(U16 freq, U16 amp)
 {
-    U8 tone_str[9];
+    U8 tone_str[12];    // two U16, "65535,65535"
     
-    sprintf((char * )tone_str, "%d,%d", freq, amp);
+    snprintf((char * )tone_str, sizeof(tone_str), "%d,%d", freq, amp);
 
     return(Audio_WriteCmd(AUDFUNC_AUD_GEN, AUDREG_GEN_TONE, tone_str));
 }
@@ -146,67 +153,46 @@ static BOOL Audio_DecSimpTone(U16 * freq, U16 * amp)
     Parameters      : exp_freq, amp_lower, amp_upper
     Return value    : PASS/FAIL
     Description     : Test the Audio signal, Compare signal value with limit, Get the PASS/FAIL conclusion.
+                      źſʼÿAUDIO_POLL_MSһνֵ, AUDIO_LOCK_K
+                      ƵʺͷֵڷΧڼPASS, AUDIO_LOCK_TMO_MSδ
+                      FAIL. ӡʱ, б.
 ******************************************************************************/
 static BOOL Audio_TestSimpTone(U16 exp_freq, U8 freq_tol, U16 amp_lower, U16 amp_upper)
 {
-    volatile U8 i;
-    BOOL ret = PASS; //ֵ
+    U32 start, now;
+    U8 lock = 0;    //ڷΧڵĴ
     U16 rx_freq;    //źŵƵ
     U16 rx_amp;     //źŵķֵ
-    OS_Delay(2000);
-    for(i=0;i<5;i++)
+
+    start = OS_GetTime32();
+    do
     {
-    	OS_Delay(500);
+    	OS_Delay(AUDIO_POLL_MS);
     	
         rx_freq = 0;
         rx_amp = 0;
 
-        Audio_DecSimpTone(&rx_freq, &rx_amp);//ȡźŵƵʺ
-        Dprintf("Audio%dHz,%dmv\r\n", rx_freq, rx_amp);
+        Audio_DecSimpTone(&rx_freq, &rx_amp);//ȡźŵƵʺͷֵ
+        now = OS_GetTime32();
         
         //ȡƵʺͷֵǷڷΧ
-        if((rx_amp < amp_upper)&&(rx_amp > amp_lower))//ֵ
-        {
-            if((rx_freq <=(exp_freq+freq_tol))&&(rx_freq >=(exp_freq-freq_tol)))//Ƶ
-            {
-                break;
-            }
-        }
-        
-        /*if(rx_freq >= exp_freq)
-        {
-            if((rx_freq - exp_freq) > freq_tol)
-            {
-                ret = FAIL;  
-            }
-        }
-        if(rx_freq < exp_freq)
+        if(Stat_InRange(rx_amp, amp_lower, amp_upper) && Stat_InRange(rx_freq, exp_freq - freq_tol, exp_freq + freq_tol))
         {
-            if((exp_freq - rx_freq) > freq_tol)
+            if(++lock >= AUDIO_LOCK_K)
             {
-                ret = FAIL;  
+                Dprintf("Audio%dHz,%dmv, lock %dms\r\n", rx_freq, rx_amp, now - start);
+                return(PASS);
             }
         }
-        
-        if(rx_amp > amp_upper)
+        else
         {
-            ret = FAIL;  
+            lock = 0;
         }
-        if(rx_amp < amp_lower)
-        {
-            ret = FAIL;  
-        }*/
-    }
-    //һûͨPassCountΪ0,жfailֻҪͨһжpass
-    if(i == 5)
-    {
-        ret = FAIL;
     }
-    else
-    {
-        ret = PASS;
-    }
-    return(ret);
+    while(now - start < AUDIO_LOCK_TMO_MS);
+
+    Dprintf("Audio%dHz,%dmv, no lock in %dms\r\n", rx_freq, rx_amp, now - start);
+    return(FAIL);
 }
 
 
@@ -293,7 +279,7 @@ BOOL Audio_CompToneAmp(U16 amp_lower, U16 amp_upper)
     if(Audio_DecSimpTone(&freq, &amp))
     {
         Dprintf("GetAmp:%dmv, lower:%dmv, upper:%dmv\r\n", amp, amp_lower, amp_upper);
-        if(amp > amp_lower && amp < amp_upper)
+        if(Stat_InRange(amp, amp_lower, amp_upper))
         {
             return(TRUE);
         }
@@ -316,7 +302,7 @@ BOOL Audio_DecToneFreq(U16 freq_lower, U16 freq_upper)
     if(Audio_DecSimpTone(&freq, &amp))
     {
         Dprintf("DecFreq:%dHz, lower:%dHz, upper:%dHz\r\n", freq, freq_lower, freq_upper);
-        if(freq > freq_lower && freq < freq_upper)
+        if(Stat_InRange(freq, freq_lower, freq_upper))
         {
             return(TRUE);
         }
@@ -324,6 +310,139 @@ BOOL Audio_DecToneFreq(U16 freq_lower, U16 freq_upper)
     return(FALSE);
 }
 
+/******************************************************************************
+    Routine Name    : Audio_LoadMask
+    Form            : U32 Audio_LoadMask(P_AUDIO_PT pts, U32 max, U16 def_lower, U16 def_upper)
+    Parameters      : pts, max, ɨƵ
+                      def_lower, def_upper, ļûдֵĵ
+    Return value    : 
+    Description     : AUDIO_MASK_FILEɨƵͷֵģ, ûļʱ
+                      300Hz, 1kHz, 3kHz.
+******************************************************************************/
+U32 Audio_LoadMask(P_AUDIO_PT pts, U32 max, U16 def_lower, U16 def_upper)
+{
+    static char mask[AUDIO_MASK_SIZE];
+    FS_FILE *fb;
+    char * line;
+    U32 num = 0;
+
+    memset(mask, 0, sizeof(mask));
+    if(fb = FS_FOpen(AUDIO_MASK_FILE,"r"))
+    {
+        FS_FRead(mask, 1, sizeof(mask) - 1, fb);
+        FS_FClose(fb);
+    }
+    else
+    {
+        strcpy(mask, "300\n1000\n3000\n");
+    }
+
+    for(line = strtok(mask, "\n"); line && num < max; line = strtok(NULL, "\n"))
+    {
+        if(*line < '0' || *line > '9')  //ע
+        {
+            continue;
+        }
+        memset(&pts[num], 0, sizeof(AUDIO_PT));
+        pts[num].freq  = (U16)strtoul(line, &line, 10);
+        pts[num].lower = def_lower;
+        pts[num].upper = def_upper;
+        if(*line == ',')
+        {
+            pts[num].lower = (U16)strtoul(line + 1, &line, 10);
+            if(*line == ',')
+            {
+                pts[num].upper = (U16)strtoul(line + 1, NULL, 10);
+            }
+        }
+        num++;
+    }
+    return(num);
+}
+
+/******************************************************************************
+    Routine Name    : Audio_Sweep
+    Form            : BOOL Audio_Sweep(P_AUDIO_PT pts, U32 num, U16 tx_amp)
+    Parameters      : pts, num, ɨƵ, amplock_ms
+                      tx_amp, ͷֵ mV
+    Return value    : PASS/FAIL, е㶼ģΪPASS
+    Description     : ֻһεģʽ, Ƶ, Ƶʶҷֵ
+                      5%ڼ, ͣһ.
+******************************************************************************/
+BOOL Audio_Sweep(P_AUDIO_PT pts, U32 num, U16 tx_amp)
+{
+    U32 i, start, now;
+    U16 rx_freq, rx_amp, last, tol;
+    U8 lock;
+    BOOL ret = PASS;
+
+    Audio_SetMode((U8 * )ModeSimp);
+
+    for(i = 0; i < num; i++)
+    {
+        Audio_GenSimpTone(pts[i].freq, tx_amp);
+        tol = AUDIO_FREQ_TOLERANCE + pts[i].freq / 200;
+        start = OS_GetTime32();
+        lock = 0;
+        last = 0;
+        do
+        {
+            OS_Delay(AUDIO_POLL_MS);
+            rx_freq = 0;
+            rx_amp = 0;
+            Audio_DecSimpTone(&rx_freq, &rx_amp);
+            now = OS_GetTime32();
+
+            if(Stat_InRange(rx_freq, pts[i].freq - tol, pts[i].freq + tol))
+            {
+                lock = (lock && Stat_InRange(rx_amp, last - last / 20, last + last / 20)) ? lock + 1 : 1;
+                last = rx_amp;
+            }
+            else
+            {
+                lock = 0;
+            }
+        }
+        while(lock < 2 && now - start < AUDIO_SWEEP_TMO_MS);
+
+        pts[i].amp = (lock >= 2) ? last : 0;
+        pts[i].lock_ms = (U16)(now - start);
+        if(Stat_InRange(pts[i].amp, pts[i].lower, pts[i].upper) == FALSE)
+        {
+            ret = FAIL;
+        }
+        Dprintf("Sweep %dHz: %dmv [%d,%d] %dms\r\n", pts[i].freq, pts[i].amp, pts[i].lower, pts[i].upper, pts[i].lock_ms);
+    }
+
+    Audio_StopSignal();
+    return(ret);
+}
+
+/******************************************************************************
+    Routine Name    : Audio_SendDTMF
+    Form            : BOOL Audio_SendDTMF(U8 * digits, U16 sig_ms, U16 spac_ms)
+    Parameters      : digits, ִ
+                      sig_ms, spac_ms, ÿֵźźͼʱ
+    Return value    : TRUE/FALSE
+    Description     : ʱһDTMF, ȷٻص.
+******************************************************************************/
+BOOL Audio_SendDTMF(U8 * digits, U16 sig_ms, U16 spac_ms)
+{
+    BOOL ret;
+
+    if(Audio_SetMode((U8 * )ModeDTMF) == FALSE || Audio_ConfigDTMF(sig_ms, spac_ms) == FALSE)
+    {
+        return(FALSE);
+    }
+
+    ret = Audio_GenDTMF(digits);
+    OS_Delay(strlen((char * )digits) * (sig_ms + spac_ms) + AUDIO_DTMF_TAIL_MS);
+    Audio_StopSignal();
+    Dprintf("DTMF %s, %d/%dms\r\n", digits, sig_ms, spac_ms);
+
+    return(ret);
+}
+
 BOOL Audio_Open(void)
 {
     Audio_SetMode((U8 * )ModeSimp);
@@ -23,6 +23,8 @@
 
 const U8 WriteStr_EmptData[] = "";
 
+static OS_RSEMA MerakLock;      //ͬʱֻһ֡, Ҳ
+
 /**************************************************************************** 
 : BcdStr2Hex 
 : BCDַ תʮ
@@ -316,6 +318,7 @@ static BOOL MERAK_CMD(U8 * board_id, U8 board_num, U8 func, U8 reg, U8 * tx_data
     
     p_tx_frame = &MERAK_TxFrame;
     
+    OS_Use(&MerakLock);
     UsartRecvReset(MERAK_COMM_PORT);
 
     MERAK_BuildFrame(p_tx_frame, board_id, board_num, func, reg, tx_data);
@@ -329,6 +332,7 @@ static BOOL MERAK_CMD(U8 * board_id, U8 board_num, U8 func, U8 reg, U8 * tx_data
         }
         OS_Delay(1);
     }
+    OS_Unuse(&MerakLock);
 
     if(i < 500)
     {
@@ -397,6 +401,20 @@ BOOL MERAK_ReadCmd(U8 * board_id, U8 board_num, U8 func, U8 reg, U8 * read_str)
 
 void RS485_Test();
 
+/*********************************************************************************
+function:    MERAK_Init
+
+description: , 񴴽ǰ
+
+parameters:  void
+
+return: void
+*********************************************************************************/
+void MERAK_Init(void)
+{
+    OS_CREATERSEMA(&MerakLock);
+}
+
 /*********************************************************************************
 function:    MERAK_ResetALL
 
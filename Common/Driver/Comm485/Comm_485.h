@@ -45,6 +45,7 @@ typedef struct
 extern void Hex2Str(U8 * str, U8 hex_data);
 extern BOOL MERAK_WriteCmd(U8 * board_id, U8 board_num, U8 func, U8 reg, U8 * write_str);
 extern BOOL MERAK_ReadCmd(U8 * board_id, U8 board_num, U8 func, U8 reg, U8 * read_str);
+extern void MERAK_Init(void);
 extern void MERAK_ResetALL(void);
 
 #endif
@@ -17,143 +17,316 @@
 #define DEFAULT_TIMEOUT_MS          (1000)
 #define DEFAULT_CMD_REPEAD_TIMES    (10)
 #define RECEIVE_BUFF_SIZE           (250) 
-U32 Cmd_ListenSn(U32 usart, U8 *rspPass)
+
+#define PRBS_CHUNK_SIZE             (64)    // ÿηPDCֽ
+#define PRBS_CHUNK_NUM              (3)     // PDCǰ/һ֡ռһ, 
+#define PRBS_SEED                   (0x7FFF)
+#define PRBS_DRAIN_MS               (50)    // ֹͣͺ, ʱûյݼ
+
+/******************************************************************************
+*   Routine Name    : Cmd_SetSpec
+*   Parameters      : spec:Ӧ pass:Pass־ fail:Fail־(ΪNULL)
+*                     mode:RSP_EXACT/RSP_PREFIX scale:ȡֵı, 0Ϊȡֵ
+*   Return value    : none
+*   Description     : ֱӦ, ʱΪDEFAULT_TIMEOUT_MS, ÿ1msѯһ
+******************************************************************************/
+void Cmd_SetSpec(P_RSP_SPEC spec, U8 *pass, U8 *fail, U8 mode, U32 scale)
 {
-    U32 recvbyte;
-    U32 recvflag = FALSE;
-    U8 recvbuf[RECEIVE_BUFF_SIZE];
-    U32 i; 
+    strncpy((char *)spec->pass, (char *)pass, CMD_STR_MAX);
+    spec->pass[CMD_STR_MAX] = 0;
+    spec->fail[0] = 0;
+    if(fail)
+    {
+        strncpy((char *)spec->fail, (char *)fail, CMD_STR_MAX);
+        spec->fail[CMD_STR_MAX] = 0;
+    }
+    spec->mode       = scale ? RSP_PREFIX : mode;
+    spec->scale      = scale;
+    spec->timeout_ms = DEFAULT_TIMEOUT_MS;
+    spec->poll_ms    = 1;
+    spec->elapsed_ms = 0;
+}
 
-    for(i = 0; i < 1000; i++)
+/******************************************************************************
+*   Routine Name    : Cmd_Compile
+*   Parameters      : spec:Ӧ pattern:Pass־ fail:Fail־
+*   Return value    : none
+*   Description     : ѲļӦַӦ:
+*                     "OK"      ȫͬ
+*                     "VER*"    "VER"ͷ
+*                     "ADC=%d"  "ADC="ͷ, ȡ
+*                     "VOL=%v"  "VOL="ͷ, ȡֵ1000, lower/upperĵλͬ
+******************************************************************************/
+void Cmd_Compile(P_RSP_SPEC spec, U8 *pattern, U8 *fail)
+{
+    U32 len;
+
+    Cmd_SetSpec(spec, pattern, fail, RSP_EXACT, 0);
+
+    len = strlen((char *)spec->pass);
+    if(len >= 2 && spec->pass[len - 2] == '%')
     {
-        if(UsartGetFrame_by_2BytesEnd(usart, '\r', '\n', recvbuf, sizeof(recvbuf),(INT32U *)&recvbyte) == 0)
+        if(spec->pass[len - 1] == 'd')
         {
-            recvbuf[recvbyte - 2] = 0;   //Remove "\r\n"
-            if(strncmp((char * )recvbuf, (char *)rspPass, strlen(rspPass)) == 0)
-            {
-                recvflag = TRUE;
-                break;
-            }
+            spec->scale = 1;
         }
-        OS_Delay(3);
+        else if(spec->pass[len - 1] == 'v')
+        {
+            spec->scale = 1000;
+        }
+        if(spec->scale)
+        {
+            spec->pass[len - 2] = 0;
+            spec->mode = RSP_PREFIX;
+        }
+    }
+    else if(len >= 1 && spec->pass[len - 1] == '*')
+    {
+        spec->pass[len - 1] = 0;
+        spec->mode = RSP_PREFIX;
     }
-    return(recvflag);
 }
 
-U32 Cmd_Listen(U32 usart, U8 *rspPass)
+/******************************************************************************
+*   Routine Name    : Trans_ParseNum
+*   Parameters      : s:ֵַ scale:(1,10,100,1000...)
+*   Return value    : ֵscale, Сλȥ
+*   Description     : , strtod
+******************************************************************************/
+static I32 Trans_ParseNum(U8 *s, U32 scale)
 {
-    U32 recvbyte;
-    U32 recvflag = FALSE;
-    U8 recvbuf[RECEIVE_BUFF_SIZE];
-    U8 i; 
+    I32 sign = 1;
+    U32 v = 0;
+    U32 frac = 0;
+    U32 div = 1;
 
-    for(i = 0; i < 100; i++)
+    while(*s == ' ')
     {
-        if(UsartGetFrame_by_2BytesEnd(usart, '\r', '\n', recvbuf, sizeof(recvbuf),(INT32U *)&recvbyte) == 0)
+        s++;
+    }
+    if(*s == '-')
+    {
+        sign = -1;
+        s++;
+    }
+    else if(*s == '+')
+    {
+        s++;
+    }
+    while(*s >= '0' && *s <= '9')
+    {
+        v = v * 10 + (*s++ - '0');
+    }
+    v *= scale;
+    if(*s == '.')
+    {
+        s++;
+        while(*s >= '0' && *s <= '9' && div < scale)
         {
-            recvbuf[recvbyte - 2] = 0;   //Remove "\r\n"
-            if(strcmp((char * )recvbuf, (char * )rspPass) == 0)
+            frac = frac * 10 + (*s++ - '0');
+            div *= 10;
+        }
+        v += frac * (scale / div);
+    }
+    return(sign * (I32)v);
+}
+
+/******************************************************************************
+*   Routine Name    : Trans_MatchLine
+*   Parameters      : spec:Ӧ line:յһ(ȥ"\r\n") value:ȡֵ
+*   Return value    : RSP_PASS/RSP_FAIL/RSP_NONE
+*   Description     : һɨͬʱȽPassFail־, ǰ׺ƥֱȡֵ
+******************************************************************************/
+static U32 Trans_MatchLine(P_RSP_SPEC spec, U8 *line, I32 *value)
+{
+    U8 *s = line;
+    U8 *p = spec->pass;
+    U8 *f = spec->fail;
+    BOOL pm = TRUE;
+    BOOL fm = (*f != 0);
+
+    while(1)
+    {
+        if(pm && *p == 0 && spec->mode == RSP_PREFIX)//ǰ׺ƥ
+        {
+            if(spec->scale && value)
             {
-                recvflag = TRUE;
-                break;
+                *value = Trans_ParseNum(s, spec->scale);
             }
+            return(RSP_PASS);
+        }
+        if(*s == 0)
+        {
+            break;
+        }
+        if(pm)
+        {
+            pm = (*p != 0 && *p++ == *s);
         }
-        OS_Delay(3);
+        if(fm)
+        {
+            fm = (*f != 0 && *f++ == *s);
+        }
+        if(!pm && !fm)
+        {
+            return(RSP_NONE);
+        }
+        s++;
     }
-    return(recvflag);
+
+    if(pm && *p == 0)
+    {
+        return(RSP_PASS);
+    }
+    if(fm && *f == 0)
+    {
+        return(RSP_FAIL);
+    }
+    return(RSP_NONE);
 }
+
 /******************************************************************************
-*   Routine Name    : Cmd_Ack
-*   Parameters      : usart:ں testCmd:Ҫ͵ rspPass:Pass־  rspFail:fial־
-*   Return value    : PASSFail
-*   Description     : Ӧ ȷ,ٸݲжϷֵPassFail
-*                     ֵrspPassrspFail,Ҫȴ10S,ĲǺܺ
+*   Routine Name    : Cmd_Trans
+*   Parameters      : usart:ں testCmd:Ҫ͵(մNULLΪ)
+*                     spec:Ӧ value:ȡֵ(ΪNULL)
+*   Return value    : RSP_PASS/RSP_FAIL/RSP_TIMEOUT
+*   Description     : DUT: , ȻбȽӦ, ֱPass/Failʱ
 ******************************************************************************/
-U32 Cmd_Ack(U32 usart, U8 *testCmd, U8 *rspPass, U8 * rspFail)
+U32 Cmd_Trans(U32 usart, U8 *testCmd, P_RSP_SPEC spec, I32 *value)
 {
-    U32 i; 
-    U32 recvbyte;        //յֽ
-    U32 recvflag = FALSE;//ر־
-    U8 txCmd[40];        //buffer
-    U8 recvbuf[RECEIVE_BUFF_SIZE];     //buffer 
+    U32 start;
+    U32 recvbyte;                   //յֽ
+    U32 ret;
+    U8 txCmd[CMD_STR_MAX + 3];      //buffer
+    U8 recvbuf[RECEIVE_BUFF_SIZE];  //buffer
+    U8 i;
+
+    start = OS_GetTime32();
 
-    if( *testCmd )//,
+    if(testCmd && *testCmd)//,
     {
         UsartRecvReset(usart); //λ
-        sprintf((char *)txCmd, "%s\r\n", (char * )testCmd);
+        for(i = 0; i < CMD_STR_MAX && testCmd[i]; i++)
+        {
+            txCmd[i] = testCmd[i];
+        }
+        txCmd[i++] = '\r';
+        txCmd[i++] = '\n';
+        txCmd[i]   = 0;
         UsartPutStr(usart, txCmd); //
     }
-	
-    if( *rspPass == 0 )
+
+    if(spec->pass[0] == 0 && spec->scale == 0)
     {
-        return(TRUE);
+        return(RSP_PASS);
     }
 
-    for(i = 0; i < DEFAULT_TIMEOUT_MS; i++)
+    do
     {
-        if(UsartGetFrame_by_2BytesEnd(usart, '\r', '\n', recvbuf, sizeof(recvbuf),(INT32U *)&recvbyte) == 0)//õ
+        while(UsartGetFrame_by_2BytesEnd(usart, '\r', '\n', recvbuf, sizeof(recvbuf), (INT32U *)&recvbyte) == RECV_OK)//õ
         {
             recvbuf[recvbyte - 2] = 0;   //Remove "\r\n"
-            if(strcmp((char * )recvbuf, (char * )rspPass) == 0)//жPass־
+            ret = Trans_MatchLine(spec, recvbuf, value);
+            if(ret != RSP_NONE)
             {
-                recvflag = TRUE; 
-                break;
-            }
-            if(* rspFail)
-            {
-                if(strcmp((char * )recvbuf, (char * )rspFail) == 0)//жFail־
-                {
-                    break;
-                }
+                spec->elapsed_ms = OS_GetTime32() - start;
+                return(ret);
             }
         }
-        OS_Delay(1);
+        OS_Delay(spec->poll_ms);
     }
+    while(OS_GetTime32() - start < spec->timeout_ms);
 
-    return(recvflag);
+    spec->elapsed_ms = OS_GetTime32() - start;
+    return(RSP_TIMEOUT);
 }
+
 /******************************************************************************
-*   Routine Name    : Cmd_ReadData
-*   Parameters      : usart:ں sq:ص pitem
-*   Return value    : PASSFail
-*   Description     : ȡ,ֻܷ,ɷַ
+*   Routine Name    : Cmd_GetLine
+*   Parameters      : usart:ں line:յһ(ȥ"\r\n") size:lineĴС
+*   Return value    : г, ûһʱΪ0
+*   Description     : ȴ, ȡһյ, 첽
 ******************************************************************************/
-U32 Cmd_ReadData(U32 usart,U32 *sq, P_ITEM_T pitem)
+U32 Cmd_GetLine(U32 usart, U8 *line, U32 size)
 {
-    U8 recvbyte;
-    U8 recvbuf[30];
-    U8 txCmd[30];
-    U8 i;
-    U8 len;
-    int data;
-    len = strlen((char * )pitem->RspCmdPass);
-    memset(recvbuf, 0 ,30);
-    UsartRecvReset(usart); //λ
-    sprintf((char *)txCmd, "%s\r\n", (char * )pitem->TestCmd);
-    UsartPutStr(usart, txCmd);//
-    
-    for(i=0;i<100;i++)
+    U32 recvbyte;
+    U8 recvbuf[RECEIVE_BUFF_SIZE];
+
+    do  //
     {
-        if(UsartGetFrame_by_2BytesEnd(usart, '\r','\n', recvbuf, sizeof(recvbuf),(INT32U * )&recvbyte) == 0)//õ
+        if(UsartGetFrame_by_2BytesEnd(usart, '\r', '\n', recvbuf, sizeof(recvbuf), (INT32U *)&recvbyte) != RECV_OK)
         {
-		    if(strncmp((char * )pitem->RspCmdPass, (char * )recvbuf, len) == 0)//жϷݵͷ
-		    {
-                //* sq = (U8)strtod((char *)(recvbuf+len), NULL); //ȡ
-                data = strtod((char *)(recvbuf+len), NULL); //ȡ
-                *sq = abs(data);
-                break;
-            }
+            return(0);
         }
-        OS_Delay(10);
     }
-    if(i < 100)
+    while(recvbyte <= 2);
+
+    recvbyte -= 2;   //Remove "\r\n"
+    if(recvbyte >= size)
     {
-        return(TRUE);
+        recvbyte = size - 1;
     }
-    else
+    memcpy(line, recvbuf, recvbyte);
+    line[recvbyte] = 0;
+    return(recvbyte);
+}
+
+U32 Cmd_ListenSn(U32 usart, U8 *rspPass)
+{
+    RSP_SPEC spec;
+
+    Cmd_SetSpec(&spec, rspPass, NULL, RSP_PREFIX, 0);
+    spec.timeout_ms = 3000;
+    spec.poll_ms    = 3;
+
+    return(Cmd_Trans(usart, NULL, &spec, NULL) == RSP_PASS);
+}
+
+U32 Cmd_Listen(U32 usart, U8 *rspPass)
+{
+    RSP_SPEC spec;
+
+    Cmd_SetSpec(&spec, rspPass, NULL, RSP_EXACT, 0);
+    spec.timeout_ms = 300;
+    spec.poll_ms    = 3;
+
+    return(Cmd_Trans(usart, NULL, &spec, NULL) == RSP_PASS);
+}
+/******************************************************************************
+*   Routine Name    : Cmd_Ack
+*   Parameters      : usart:ں testCmd:Ҫ͵ rspPass:Pass־  rspFail:fial־
+*   Return value    : PASSFail
+*   Description     : Ӧ ȷ,ٸݲжϷֵPassFail
+*                     ֵrspPassrspFail,ȴDEFAULT_TIMEOUT_MS󷵻Fail
+******************************************************************************/
+U32 Cmd_Ack(U32 usart, U8 *testCmd, U8 *rspPass, U8 * rspFail)
+{
+    RSP_SPEC spec;
+
+    Cmd_SetSpec(&spec, rspPass, rspFail, RSP_EXACT, 0);
+
+    return(Cmd_Trans(usart, testCmd, &spec, NULL) == RSP_PASS);
+}
+/******************************************************************************
+*   Routine Name    : Cmd_ReadData
+*   Parameters      : usart:ں sq:ص pitem
+*   Return value    : PASSFail
+*   Description     : ȡ,ֻܷ,ɷַ
+******************************************************************************/
+U32 Cmd_ReadData(U32 usart,U32 *sq, P_ITEM_T pitem)
+{
+    RSP_SPEC spec;
+    I32 data = 0;
+
+    Cmd_SetSpec(&spec, pitem->RspCmdPass, NULL, RSP_PREFIX, 1);
+    spec.poll_ms = 10;
+
+    if(Cmd_Trans(usart, pitem->TestCmd, &spec, &data) != RSP_PASS)
     {
         return(FALSE);
     }
+    *sq = abs(data); //ȡ
+    return(TRUE);
 }
 #ifdef LYNX_AP_MAIN
 
@@ -171,6 +344,25 @@ void Get_LynxComm(U8 * item)
     }
 }
 #endif
+/******************************************************************************
+    Routine Name    : Cmd_GetTmo
+    Parameters      : pitem spec:صӦ
+    Return value    : ĳʱ¼, ûӦ־ʱΪNULL
+    Description     : Ӧʱ¼óʱ, Comm_tmo.c
+******************************************************************************/
+static P_CMD_TMO Cmd_GetTmo(P_ITEM_T pitem, P_RSP_SPEC spec)
+{
+    P_CMD_TMO ptmo = NULL;
+
+    Cmd_SetSpec(spec, pitem->RspCmdPass, pitem->RspCmdFail, RSP_EXACT, 0);
+    if(*pitem->RspCmdPass)
+    {
+        ptmo = CmdTmo_Get(*pitem->TestCmd ? pitem->TestCmd : pitem->RspCmdPass);
+    }
+    spec->timeout_ms = CmdTmo_Timeout(ptmo, DEFAULT_TIMEOUT_MS);
+
+    return(ptmo);
+}
 /******************************************************************************
     Routine Name    : Cmd_Proc
     Parameters      : pitem
@@ -180,9 +372,16 @@ void Get_LynxComm(U8 * item)
 U32 Cmd_Proc(P_ITEM_T pitem)
 {
     U8 i;
-    U8 Cmd_CntMax = DEFAULT_CMD_REPEAD_TIMES;
+    U8 Cmd_CntMax;
+    U32 ret;
+    RSP_SPEC spec;
+    P_CMD_TMO ptmo;
     
-    if(strcmp((char * )pitem->id, "CMD") == 0)  //For "CMD" command, Param indicate maximum repeat time
+    ptmo = Cmd_GetTmo(pitem, &spec);
+    Cmd_CntMax = CmdTmo_Retries(ptmo, DEFAULT_CMD_REPEAD_TIMES);
+
+    //For "CMD" command, Param indicate maximum repeat time, also for "CMDB" repeated by Cmd_Batch
+    if(strcmp((char * )pitem->id, "CMD") == 0 || strcmp((char * )pitem->id, "CMDB") == 0)
     {
         if(pitem->Param)
         {
@@ -194,14 +393,20 @@ U32 Cmd_Proc(P_ITEM_T pitem)
 	{
 #ifdef LYNX_AP_MAIN
 	    Get_LynxComm(pitem->item);
-    	if(Cmd_Ack(comm, pitem->TestCmd, pitem->RspCmdPass, pitem->RspCmdFail))
+    	ret = Cmd_Trans(comm, pitem->TestCmd, &spec, NULL);
 #else
-    	if(Cmd_Ack(DUT_COMM_PORT, pitem->TestCmd, pitem->RspCmdPass, pitem->RspCmdFail))
+    	ret = Cmd_Trans(DUT_COMM_PORT, pitem->TestCmd, &spec, NULL);
 #endif
+    	if(ret == RSP_PASS)
     	{
     	    break;
     	}
+    	if(ret == RSP_TIMEOUT)
+    	{
+    	    CmdTmo_Miss(ptmo, spec.timeout_ms);    //ʱһҲҪ, ʱֻԽѧԽ
+    	}
 	}
+	CmdTmo_Update(ptmo, i < Cmd_CntMax, i + 1, spec.elapsed_ms);
 	
     if(i < Cmd_CntMax)
     {
@@ -231,16 +436,399 @@ U32 Cmd_Aux(P_ITEM_T pitem)
         return(TRUE);
 	}*/
     U32 i;
-    for(i=0; i<10; i++)
+    U32 Cmd_CntMax;
+    U32 ret;
+    RSP_SPEC spec;
+    P_CMD_TMO ptmo;
+
+    ptmo = Cmd_GetTmo(pitem, &spec);
+    Cmd_CntMax = CmdTmo_Retries(ptmo, DEFAULT_CMD_REPEAD_TIMES);
+
+    for(i=0; i<Cmd_CntMax; i++)
     {
-        if(Cmd_Ack(pitem->Channel, pitem->TestCmd, pitem->RspCmdPass, pitem->RspCmdFail))
+        ret = Cmd_Trans(pitem->Channel, pitem->TestCmd, &spec, NULL);
+        if(ret == RSP_PASS)
         {
+            CmdTmo_Update(ptmo, TRUE, i + 1, spec.elapsed_ms);
             return(TRUE);
         }
+        if(ret == RSP_TIMEOUT)
+        {
+            CmdTmo_Miss(ptmo, spec.timeout_ms);
+        }
         Dprintf("Repeat the CMD!\r\n");
     }
     
+    CmdTmo_Update(ptmo, FALSE, i, spec.elapsed_ms);
     return(FALSE);
 }
 
 
+
+/******************************************************************************
+*   Routine Name    : Cmd_StreamStop
+*   Parameters      : usart:ں testCmd:ʼ left:DUTҪ͵
+*                     gap_ms:֮
+*   Return value    : none
+*   Description     : ǰֹͣʱDUTڷ, ʣµлᱻһӦ.
+*                     '='0("FCT+RSSI=50""FCT+RSSI=0")DUTֹͣ,
+*                     Ȼʣµ, ֱgap_msû, ʣµ.
+******************************************************************************/
+static void Cmd_StreamStop(U32 usart, U8 *testCmd, U32 left, U32 gap_ms)
+{
+    U8 stopCmd[CMD_STR_MAX + 3];
+    U8 line[RECEIVE_BUFF_SIZE];
+    U8 * eq;
+    U32 start, quiet;
+
+    if(testCmd && (eq = (U8 *)strchr((char *)testCmd, '=')) != NULL && eq - testCmd < CMD_STR_MAX - 1)
+    {
+        memcpy(stopCmd, testCmd, eq - testCmd + 1);
+        strcpy((char *)&stopCmd[eq - testCmd + 1], "0\r\n");
+        UsartPutStr(usart, stopCmd);
+    }
+
+    start = OS_GetTime32();
+    quiet = start;
+    while(OS_GetTime32() - quiet < gap_ms && OS_GetTime32() - start < (left + 1) * gap_ms)
+    {
+        if(Cmd_GetLine(usart, line, sizeof(line)))
+        {
+            quiet = OS_GetTime32();
+        }
+        else
+        {
+            OS_Delay(2);
+        }
+    }
+}
+
+/******************************************************************************
+*   Routine Name    : Cmd_Stream
+*   Parameters      : usart:ں testCmd:DUT spec:Ӧ
+*                     count: fn:ÿĴ arg:fnĲ
+*   Return value    : յ
+*   Description     : ֻһ, ֮DUT, ÿһfn.
+*                     spec->timeout_msΪ֮. fnFALSEʱǰֹͣ,
+*                     Cmd_StreamStop.
+******************************************************************************/
+U32 Cmd_Stream(U32 usart, U8 *testCmd, P_RSP_SPEC spec, U32 count, STREAM_FUNC fn, void * arg)
+{
+    U32 n = 0;
+    I32 value = 0;
+
+    while(n < count && Cmd_Trans(usart, n ? NULL : testCmd, spec, &value) == RSP_PASS)
+    {
+        n++;
+        if(fn(value, arg) == FALSE)
+        {
+            if(n < count)
+            {
+                Cmd_StreamStop(usart, testCmd, count - n, spec->timeout_ms);
+            }
+            break;
+        }
+    }
+    return(n);
+}
+
+static BOOL Stream_CheckSample(I32 value, void * arg)
+{
+    P_STREAM_CHK chk = (P_STREAM_CHK)arg;
+
+    Stat_Add(&chk->acc, chk->absVal ? abs(value) : value);
+    if(chk->acc.n < chk->minCount)
+    {
+        return(TRUE);
+    }
+
+    chk->verdict = Stat_CiCheck(&chk->acc, chk->lower, chk->upper, STAT_Z_997);
+    if(chk->verdict == STAT_INSIDE && chk->varMax && Stat_Var(&chk->acc) > chk->varMax)
+    {
+        chk->verdict = STAT_UNSURE;    // ƽֵû, Ҫȫ
+    }
+    return(chk->verdict == STAT_UNSURE);
+}
+
+/******************************************************************************
+*   Routine Name    : Cmd_StreamCheck
+*   Parameters      : usart:ں testCmd:DUT spec:Ӧ
+*                     count: chk:, ͳƽ
+*   Return value    : TRUEFALSE
+*   Description     : Cmd_Stream, һɨõƽֵ///Сֵ.
+*                     ƽֵ99.7%(ҷ)ʱǰֹͣ,
+*                     countƽֵͷж.
+******************************************************************************/
+U32 Cmd_StreamCheck(U32 usart, U8 *testCmd, P_RSP_SPEC spec, U32 count, P_STREAM_CHK chk)
+{
+    I32 mean;
+    U32 var;
+
+    Stat_Reset(&chk->acc);
+    chk->verdict = STAT_UNSURE;
+
+    Cmd_Stream(usart, testCmd, spec, count, Stream_CheckSample, chk);
+    if(chk->acc.n == 0)
+    {
+        return(FALSE);
+    }
+
+    mean = Stat_Mean(&chk->acc);
+    var  = Stat_Var(&chk->acc);
+    Dprintf("\r\nn = %d, Average = %d, Variance = %d, Min = %d, Max = %d\r\n",
+            chk->acc.n, mean, var, chk->acc.min, chk->acc.max);
+
+    if(chk->verdict != STAT_UNSURE)
+    {
+        return(chk->verdict == STAT_INSIDE);
+    }
+    if(chk->acc.n < count)
+    {
+        return(FALSE);     // 
+    }
+    if(chk->varMax && var > chk->varMax)
+    {
+        return(FALSE);
+    }
+    return(Stat_InRange(mean, chk->lower, chk->upper));
+}
+
+/******************************************************************************
+*   Routine Name    : Cmd_Batch
+*   Parameters      : usart:ں pitems: num:(CMD_BATCH_MAX)
+*   Return value    : TRUE(ȫPass)FALSE, ÿĽretResult
+*   Description     : : , Ӧʱ˳δɵƥ,
+*                     һPass/Fail־õӦ. Ӧ־ͬ˳ƥ.
+*                     ѧϰʱûӦֹͣȴ, ûеõPass
+*                     Cmd_Proc, ֻһʱDUT.
+*                     Ӧֻ֮мms, ĳʱѧϰ, 򵥶ʱʱ̫.
+******************************************************************************/
+U32 Cmd_Batch(U32 usart, P_ITEM_T pitems, U32 num)
+{
+    RSP_SPEC spec[CMD_BATCH_MAX];
+    U8 txCmd[CMD_BATCH_MAX * (CMD_STR_MAX + 2) + 1];   //buffer
+    U8 recvbuf[RECEIVE_BUFF_SIZE];                      //buffer
+    U32 recvbyte;
+    U32 i, len, pending, ret;
+    U32 timeout = 0;
+    U32 start, last;
+    BOOL done[CMD_BATCH_MAX];
+    BOOL allPass = TRUE;
+
+    if(num > CMD_BATCH_MAX)
+    {
+        num = CMD_BATCH_MAX;
+    }
+
+    len = 0;
+    pending = 0;
+    for(i = 0; i < num; i++)
+    {
+        Cmd_GetTmo(&pitems[i], &spec[i]);     //ֻȡѧĳʱ
+        if(spec[i].timeout_ms > timeout)
+        {
+            timeout = spec[i].timeout_ms;
+        }
+        if(*pitems[i].TestCmd)
+        {
+            strcpy((char *)&txCmd[len], (char *)pitems[i].TestCmd);
+            len += strlen((char *)pitems[i].TestCmd);
+            txCmd[len++] = '\r';
+            txCmd[len++] = '\n';
+        }
+        if(*pitems[i].RspCmdPass)
+        {
+            pitems[i].retResult = FAIL;
+            done[i] = FALSE;
+            pending++;
+        }
+        else
+        {
+            pitems[i].retResult = PASS;
+            done[i] = TRUE;
+        }
+    }
+    txCmd[len] = 0;
+
+    UsartRecvReset(usart); //λ
+    start = OS_GetTime32();
+    last  = start;
+    if(len)
+    {
+        UsartPutStr(usart, txCmd); //
+    }
+
+    while(pending && OS_GetTime32() - last < timeout)
+    {
+        while(pending && UsartGetFrame_by_2BytesEnd(usart, '\r', '\n', recvbuf, sizeof(recvbuf), (INT32U *)&recvbyte) == RECV_OK)
+        {
+            recvbuf[recvbyte - 2] = 0;   //Remove "\r\n"
+            for(i = 0; i < num; i++)
+            {
+                if(done[i])
+                {
+                    continue;
+                }
+                ret = Trans_MatchLine(&spec[i], recvbuf, NULL);
+                if(ret != RSP_NONE)
+                {
+                    done[i] = TRUE;
+                    pending--;
+                    if(ret == RSP_PASS)
+                    {
+                        pitems[i].retResult = PASS;
+                    }
+                    last = OS_GetTime32();
+                    break;
+                }
+            }
+        }
+        OS_Delay(1);
+    }
+
+    for(i = 0; i < num; i++)
+    {
+        if(pitems[i].retResult != PASS)
+        {
+            Dprintf("Batch: %s no answer, repeat the CMD!\r\n", pitems[i].TestCmd);
+            pitems[i].retResult = Cmd_Proc(&pitems[i]);
+        }
+        if(pitems[i].retResult != PASS)
+        {
+            allPass = FALSE;
+        }
+    }
+
+    Dprintf("Batch: %d commands in %d ms\r\n", num, OS_GetTime32() - start);
+    return(allPass);
+}
+
+/******************************************************************************
+*   Routine Name    : Prbs_NextByte
+*   Parameters      : state:LFSR״̬
+*   Return value    : һֽ
+*   Description     : PRBS15 (x^15 + x^14 + 1) , ÿֽ8λ, λȳ
+******************************************************************************/
+static U8 Prbs_NextByte(U32 *state)
+{
+    U32 i, bit;
+    U8 byte = 0;
+
+    for(i = 0; i < 8; i++)
+    {
+        bit = ((*state >> 14) ^ (*state >> 13)) & 1;
+        *state = ((*state << 1) | bit) & 0x7FFF;
+        byte = (byte << 1) | bit;
+    }
+    return(byte);
+}
+
+/******************************************************************************
+*   Routine Name    : Prbs_CheckByte
+*   Parameters      : state:LFSR״̬ byte:յֽ
+*   Return value    : Ԥֵͬλ
+*   Description     : ͬ, յλ״̬, ֽں15λͬ.
+*                     һڵ14,15λٱ, һΪ3λ
+******************************************************************************/
+static U32 Prbs_CheckByte(U32 *state, U8 byte)
+{
+    U32 i, bit;
+    U32 errbits = 0;
+
+    for(i = 0; i < 8; i++)
+    {
+        bit = (byte >> (7 - i)) & 1;
+        if(bit != (((*state >> 14) ^ (*state >> 13)) & 1))
+        {
+            errbits++;
+        }
+        *state = ((*state << 1) | bit) & 0x7FFF;
+    }
+    return(errbits);
+}
+
+/******************************************************************************
+*   Routine Name    : Cmd_PrbsLoop
+*   Parameters      : usart:ں time_ms:ʱ pres:Խ
+*   Return value    : TRUEFALSE(ںŴ)
+*   Description     : DUTڻػ/ģʽʱ, PDCPRBS15, ͬʱյ.
+*                     ͳշֽ, ֽ/λ, (Byte/s)ʹ/֡
+******************************************************************************/
+U32 Cmd_PrbsLoop(U32 usart, U32 time_ms, P_PRBS_RESULT pres)
+{
+    U8 txbuf[PRBS_CHUNK_NUM][PRBS_CHUNK_SIZE];
+    U32 txstate = PRBS_SEED;
+    U32 rxstate = 0;
+    U32 idx = 0;
+    U32 i, errbits;
+    U32 start, now, last;
+    USART_STAT stat0, stat1;
+    U8 c;
+
+    memset(pres, 0, sizeof(PRBS_RESULT));
+
+    if(UsartGetStat(usart, &stat0) == FALSE)
+    {
+        return(FALSE);
+    }
+    UsartRecvReset(usart); //λ
+
+    for(i = 0; i < PRBS_CHUNK_SIZE; i++)
+    {
+        txbuf[idx][i] = Prbs_NextByte(&txstate);
+    }
+
+    start = OS_GetTime32();
+    last  = start;
+    now   = start;
+    while(1)
+    {
+        // : PDCпλͷõBUF, һеBUF
+        if((now - start) < time_ms)
+        {
+            while(UsartSendFrameQueue(usart, txbuf[idx], PRBS_CHUNK_SIZE))
+            {
+                pres->txBytes += PRBS_CHUNK_SIZE;
+                idx = (idx + 1) % PRBS_CHUNK_NUM;
+                for(i = 0; i < PRBS_CHUNK_SIZE; i++)
+                {
+                    txbuf[idx][i] = Prbs_NextByte(&txstate);
+                }
+            }
+        }
+
+        // : ǰ2ֽͬ
+        while(UsartGetChar(usart, &c) == RECV_OK)
+        {
+            errbits = Prbs_CheckByte(&rxstate, c);
+            if(pres->rxBytes >= 2 && errbits)
+            {
+                pres->errBits += errbits;
+                pres->errBytes++;
+            }
+            pres->rxBytes++;
+            last = OS_GetTime32();
+        }
+
+        now = OS_GetTime32();
+        if((now - start) >= time_ms)
+        {
+            if(pres->rxBytes >= pres->txBytes || (now - last) > PRBS_DRAIN_MS)
+            {
+                break;
+            }
+        }
+        OS_Delay(1);
+    }
+
+    if(last > start)
+    {
+        pres->bytesPerSec = pres->rxBytes * 1000 / (last - start);
+    }
+
+    UsartGetStat(usart, &stat1);
+    pres->overrun  = stat1.overrun - stat0.overrun;
+    pres->frameErr = (stat1.frame_err - stat0.frame_err) + (stat1.parity_err - stat0.parity_err);
+
+    return(TRUE);
+}
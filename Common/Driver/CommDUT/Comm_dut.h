@@ -15,10 +15,69 @@
 
 #include "includes.h"
 
+// Cmd_Trans ֵ
+#define RSP_NONE        (0)
+#define RSP_PASS        (1)
+#define RSP_FAIL        (2)
+#define RSP_TIMEOUT     (3)
+
+#define CMD_BATCH_MAX   (8)     // , DUTջ
+
+// Ӧƥ䷽ʽ
+#define RSP_EXACT       (0)
+#define RSP_PREFIX      (1)
+
+typedef struct
+{
+    U8  pass[CMD_STR_MAX+1];    // Pass־
+    U8  fail[CMD_STR_MAX+1];    // Fail־, ȫͬFail
+    U8  mode;                   // RSP_EXACT/RSP_PREFIX
+    U32 scale;                  // ǰ׺ֵscale, 0Ϊȡֵ
+    U32 timeout_ms;
+    U32 poll_ms;
+    U32 elapsed_ms;             // Cmd_Trans ʱд, ͵Ӧʱ
+
+} RSP_SPEC, * P_RSP_SPEC;
+
+typedef BOOL (*STREAM_FUNC)(I32 value, void * arg);    // FALSEֹͣ
+
+typedef struct
+{
+    STAT_ACC acc;
+    I32 lower;          // ƽֵ, λͬ
+    I32 upper;
+    U32 varMax;         // , 0Ϊ
+    U32 minCount;       // ôǰж
+    U8  absVal;         // ȡֵ
+    U8  verdict;        // ֹͣʱж: STAT_INSIDE/STAT_OUTSIDE/STAT_UNSURE
+
+} STREAM_CHK, * P_STREAM_CHK;
+
+typedef struct
+{
+    U32 txBytes;        // ֽ
+    U32 rxBytes;        // ֽ
+    U32 errBytes;       // ֽ
+    U32 errBits;        // λ
+    U32 bytesPerSec;    //  Byte/s
+    U32 overrun;        // 
+    U32 frameErr;       // ֡У
+
+} PRBS_RESULT, * P_PRBS_RESULT;
+
 extern U32 Cmd_Proc(P_ITEM_T pitem);
 extern U32 Cmd_Aux(P_ITEM_T pitem);
 extern U32 Cmd_Ack(U32 usart, U8 * testCmd, U8 * rspPass, U8 * rspFail);
 extern U32 Cmd_ReadData(U32 usart,U32 * sq, P_ITEM_T pitem);
 extern U32 Cmd_Listen(U32 usart, U8 *rspPass);
+extern U32 Cmd_ListenSn(U32 usart, U8 *rspPass);
+extern U32 Cmd_GetLine(U32 usart, U8 *line, U32 size);
+extern void Cmd_SetSpec(P_RSP_SPEC spec, U8 *pass, U8 *fail, U8 mode, U32 scale);
+extern void Cmd_Compile(P_RSP_SPEC spec, U8 *pattern, U8 *fail);
+extern U32 Cmd_Trans(U32 usart, U8 *testCmd, P_RSP_SPEC spec, I32 *value);
+extern U32 Cmd_Stream(U32 usart, U8 *testCmd, P_RSP_SPEC spec, U32 count, STREAM_FUNC fn, void * arg);
+extern U32 Cmd_StreamCheck(U32 usart, U8 *testCmd, P_RSP_SPEC spec, U32 count, P_STREAM_CHK chk);
+extern U32 Cmd_Batch(U32 usart, P_ITEM_T pitems, U32 num);
+extern U32 Cmd_PrbsLoop(U32 usart, U32 time_ms, P_PRBS_RESULT pres);
 
 #endif
@@ -0,0 +1,378 @@
+/*******************************************************************************
+    Copyright(C) 2012, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+    File name:  Comm_tmo.c
+    Function: Adaptive DUT command timeout
+    IDE:    IAR EWARM V6.21
+    ICE:    J-Link
+    BOARD:  Merak board V1.0
+    History
+                ver.1.00    First release
+
+    The latency of every passing DUT command is kept per command string as
+    an EWMA and a histogram, and the table is saved to NAND after each DUT.
+    Once a command has CMD_TMO_LEARN samples its timeout becomes twice the
+    95th percentile (at least 3x the mean, within a quarter of the caller's
+    default and the default itself), and its retry count follows the mean
+    number of attempts it needed. A DUT that does not answer is then
+    rejected after a few hundred ms instead of 10 x 1 s. Lines
+    "cmd,timeout_ms,retries" in CmdTmo.csv override the learned values (0
+    keeps the learned one).
+
+    A pass is never slower than the timeout, so the passes alone could only
+    shrink it. Every attempt that times out is learned as a censored sample
+    at twice the timeout, which widens the window again when slower DUTs
+    come. After CMD_TMO_MISS_MAX commands in a row that needed a retry or
+    failed, the history of the command is dropped and it starts again from
+    the default.
+*******************************************************************************/
+#include "includes.h"
+
+#define CMD_TMO_LEARN       (10)            // samples before the history is used
+#define CMD_TMO_WINDOW      (256)           // histogram is halved when it gets this many samples
+#define CMD_TMO_PCT         (95)
+#define CMD_TMO_MIN_MS      (30)
+#define CMD_TMO_FLOOR_DIV   (4)             // the timeout stays above def_ms / 4
+#define CMD_TMO_MISS_MAX    (3)             // commands in a row with retries before relearning
+#define CMD_TMO_MAGIC       (0x324F4D54)    // "TMO2"
+#define CMD_TMO_CFG_SIZE    (1024)
+
+static const U16 CmdTmoEdge[CMD_TMO_BUCKETS] =
+{
+    2, 5, 10, 20, 30, 50, 75, 100, 150, 200, 300, 500, 750, 1000, 2000, 0xFFFF
+};
+
+static CMD_TMO CmdTmoTab[CMD_TMO_MAX];
+static BOOL CmdTmoDirty = FALSE;
+
+static U32 CmdTmo_Hash(U8 * str)
+{
+    U32 h = 2166136261u;    // FNV-1a
+
+    while(*str)
+    {
+        h ^= *str++;
+        h *= 16777619u;
+    }
+    return(h ? h : 1);
+}
+
+/******************************************************************************
+    Routine Name    : CmdTmo_Get
+    Parameters      : cmd
+    Return value    : the entry of the command, NULL if cmd is empty or the
+                      table is full
+    Description     : Look up a command, a new command gets a free slot.
+******************************************************************************/
+P_CMD_TMO CmdTmo_Get(U8 * cmd)
+{
+    U32 key, i;
+    P_CMD_TMO pfree = NULL;
+
+    if(cmd == NULL || *cmd == 0)
+    {
+        return(NULL);
+    }
+
+    key = CmdTmo_Hash(cmd);
+    for(i = 0; i < CMD_TMO_MAX; i++)
+    {
+        if(CmdTmoTab[i].key == key)
+        {
+            return(&CmdTmoTab[i]);
+        }
+        if(CmdTmoTab[i].key == 0 && pfree == NULL)
+        {
+            pfree = &CmdTmoTab[i];
+        }
+    }
+
+    if(pfree)
+    {
+        memset(pfree, 0, sizeof(CMD_TMO));
+        pfree->key   = key;
+        pfree->att16 = 16;
+    }
+    return(pfree);
+}
+
+static U32 CmdTmo_Percentile(P_CMD_TMO ptmo)
+{
+    U32 i;
+    U32 sum = 0;
+    U32 need = (ptmo->total * CMD_TMO_PCT + 99) / 100;
+
+    for(i = 0; i < CMD_TMO_BUCKETS - 1; i++)
+    {
+        sum += ptmo->hist[i];
+        if(sum >= need)
+        {
+            break;
+        }
+    }
+    return(CmdTmoEdge[i]);
+}
+
+U32 CmdTmo_Timeout(P_CMD_TMO ptmo, U32 def_ms)
+{
+    U32 tmo;
+
+    if(ptmo == NULL)
+    {
+        return(def_ms);
+    }
+    if(ptmo->tmoOver)
+    {
+        return(ptmo->tmoOver);
+    }
+    if(ptmo->total < CMD_TMO_LEARN)
+    {
+        return(def_ms);
+    }
+
+    tmo = CmdTmo_Percentile(ptmo) * 2;
+    if(tmo < ptmo->ewma8 * 3 / 8)
+    {
+        tmo = ptmo->ewma8 * 3 / 8;
+    }
+    if(tmo < def_ms / CMD_TMO_FLOOR_DIV)
+    {
+        tmo = def_ms / CMD_TMO_FLOOR_DIV;
+    }
+    if(tmo < CMD_TMO_MIN_MS)
+    {
+        tmo = CMD_TMO_MIN_MS;
+    }
+    if(tmo > def_ms)
+    {
+        tmo = def_ms;
+    }
+    return(tmo);
+}
+
+U32 CmdTmo_Retries(P_CMD_TMO ptmo, U32 def_times)
+{
+    U32 n;
+
+    if(ptmo == NULL)
+    {
+        return(def_times);
+    }
+    if(ptmo->retryOver)
+    {
+        return(ptmo->retryOver);
+    }
+    if(ptmo->total < CMD_TMO_LEARN)
+    {
+        return(def_times);
+    }
+
+    n = (ptmo->att16 + 15) / 16 + 1;    // one more than it usually needs
+    if(n > def_times)
+    {
+        n = def_times;
+    }
+    return(n);
+}
+
+static void CmdTmo_AddSample(P_CMD_TMO ptmo, U32 latency_ms)
+{
+    U32 i;
+
+    for(i = 0; i < CMD_TMO_BUCKETS - 1; i++)
+    {
+        if(latency_ms <= CmdTmoEdge[i])
+        {
+            break;
+        }
+    }
+    ptmo->hist[i]++;
+    ptmo->total++;
+    if(ptmo->total >= CMD_TMO_WINDOW)   // forget the old samples
+    {
+        ptmo->total = 0;
+        for(i = 0; i < CMD_TMO_BUCKETS; i++)
+        {
+            ptmo->hist[i] /= 2;
+            ptmo->total += ptmo->hist[i];
+        }
+    }
+}
+
+/******************************************************************************
+    Routine Name    : CmdTmo_Miss
+    Parameters      : ptmo, tmo_ms, the timeout the attempt used
+    Return value    : none
+    Description     : Learn from one attempt that timed out. Its latency is
+                      only known to be longer than tmo_ms, it is counted as
+                      2 x tmo_ms so the next timeout is at least doubled
+                      once enough of them are seen.
+******************************************************************************/
+void CmdTmo_Miss(P_CMD_TMO ptmo, U32 tmo_ms)
+{
+    if(ptmo == NULL || ptmo->total < CMD_TMO_LEARN)    // still on the default
+    {
+        return;
+    }
+
+    CmdTmo_AddSample(ptmo, tmo_ms * 2);
+    CmdTmoDirty = TRUE;
+}
+
+/******************************************************************************
+    Routine Name    : CmdTmo_Update
+    Parameters      : ptmo, pass, attempts, latency_ms
+    Return value    : none
+    Description     : Learn from one command. The latency of a failed
+                      command is not learned, a dead DUT must not stretch
+                      the timeout, but a run of commands that needed retries
+                      sends the command back to the default.
+******************************************************************************/
+void CmdTmo_Update(P_CMD_TMO ptmo, U32 pass, U32 attempts, U32 latency_ms)
+{
+    if(ptmo == NULL)
+    {
+        return;
+    }
+
+    if(pass == FALSE || attempts > 1)
+    {
+        if(++ptmo->misses >= CMD_TMO_MISS_MAX)
+        {
+            memset(ptmo->hist, 0, sizeof(ptmo->hist));
+            ptmo->total  = 0;
+            ptmo->misses = 0;
+            ptmo->att16  = 16;
+        }
+        CmdTmoDirty = TRUE;
+    }
+    else
+    {
+        ptmo->misses = 0;
+    }
+
+    if(pass == FALSE)
+    {
+        return;
+    }
+
+    CmdTmo_AddSample(ptmo, latency_ms);
+
+    if(ptmo->total == 1)
+    {
+        ptmo->ewma8 = latency_ms * 8;
+    }
+    else
+    {
+        ptmo->ewma8 = ptmo->ewma8 - ptmo->ewma8 / 8 + latency_ms;
+    }
+    ptmo->att16 = (ptmo->att16 * 7 + attempts * 16) / 8;
+
+    CmdTmoDirty = TRUE;
+}
+
+static void CmdTmo_LoadCfg(void)
+{
+    static char cfg[CMD_TMO_CFG_SIZE];
+    FS_FILE *fb;
+    char * line;
+    char * next;
+    char * comma;
+    P_CMD_TMO ptmo;
+
+    memset(cfg, 0, sizeof(cfg));
+    if(fb = FS_FOpen(CMD_TMO_CFG,"r"))
+    {
+        FS_FRead(cfg, 1, sizeof(cfg) - 1, fb);
+        FS_FClose(fb);
+    }
+
+    for(line = cfg; *line; line = next)
+    {
+        next = strchr(line, '\n');
+        if(next)
+        {
+            *next++ = 0;
+        }
+        else
+        {
+            next = line + strlen(line);
+        }
+
+        comma = strchr(line, ',');
+        if(comma == NULL || *line == '/')
+        {
+            continue;
+        }
+        *comma++ = 0;
+
+        if(ptmo = CmdTmo_Get((U8 *)line))
+        {
+            ptmo->tmoOver = (U16)strtoul(comma, &comma, 10);
+            if(*comma == ',')
+            {
+                ptmo->retryOver = (U8)strtoul(comma + 1, NULL, 10);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+    Routine Name    : CmdTmo_Init
+    Parameters      : none
+    Return value    : none
+    Description     : Load the learned history and the overrides.
+******************************************************************************/
+void CmdTmo_Init(void)
+{
+    FS_FILE *fb;
+    U32 magic = 0;
+    U32 i;
+
+    memset(CmdTmoTab, 0, sizeof(CmdTmoTab));
+
+    if(fb = FS_FOpen(CMD_TMO_FILE,"rb"))
+    {
+        FS_FRead(&magic, sizeof(magic), 1, fb);
+        if(magic != CMD_TMO_MAGIC || FS_FRead(CmdTmoTab, sizeof(CmdTmoTab), 1, fb) != 1)
+        {
+            memset(CmdTmoTab, 0, sizeof(CmdTmoTab));
+        }
+        FS_FClose(fb);
+    }
+
+    for(i = 0; i < CMD_TMO_MAX; i++)
+    {
+        CmdTmoTab[i].tmoOver   = 0;
+        CmdTmoTab[i].retryOver = 0;
+    }
+    CmdTmo_LoadCfg();
+    CmdTmoDirty = FALSE;
+}
+
+/******************************************************************************
+    Routine Name    : CmdTmo_Save
+    Parameters      : none
+    Return value    : none
+    Description     : Save the history if it has changed.
+******************************************************************************/
+void CmdTmo_Save(void)
+{
+    FS_FILE *fb;
+    U32 magic = CMD_TMO_MAGIC;
+
+    if(CmdTmoDirty == FALSE)
+    {
+        return;
+    }
+
+    if(fb = FS_FOpen(CMD_TMO_FILE,"wb"))
+    {
+        FS_FWrite(&magic, sizeof(magic), 1, fb);
+        FS_FWrite(CmdTmoTab, sizeof(CmdTmoTab), 1, fb);
+        FS_SetEndOfFile(fb);
+        FS_FClose(fb);
+        CmdTmoDirty = FALSE;
+    }
+}
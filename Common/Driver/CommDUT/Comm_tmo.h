@@ -0,0 +1,43 @@
+/*******************************************************************************
+    Copyright(C) 2012, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+    File name:  Comm_tmo.h
+    Function: Adaptive DUT command timeout head file
+    IDE:    IAR EWARM V6.21
+    ICE:    J-Link
+    BOARD:  Merak board V1.0
+    History
+                ver.1.00    First release
+*******************************************************************************/
+#ifndef _HONEYWELL_FCT_COMM_TMO_H_
+#define _HONEYWELL_FCT_COMM_TMO_H_
+
+#define CMD_TMO_MAX         (64)    // commands tracked
+#define CMD_TMO_BUCKETS     (16)
+
+#define CMD_TMO_FILE        "CmdTmo.dat"    // learned history
+#define CMD_TMO_CFG         "CmdTmo.csv"    // overrides: "cmd,timeout_ms,retries"
+
+typedef struct
+{
+    U32 key;                        // hash of the command string, 0 for a free slot
+    U32 ewma8;                      // mean latency, ms x8
+    U16 hist[CMD_TMO_BUCKETS];      // latency histogram, see CmdTmoEdge[]
+    U16 total;
+    U16 att16;                      // mean attempts to pass, x16
+    U16 tmoOver;                    // configured timeout ms, 0 for learned
+    U8  retryOver;                  // configured retries, 0 for learned
+    U8  misses;                     // commands in a row that needed a retry
+
+} CMD_TMO, * P_CMD_TMO;
+
+extern void CmdTmo_Init(void);
+extern void CmdTmo_Save(void);
+extern P_CMD_TMO CmdTmo_Get(U8 * cmd);
+extern U32  CmdTmo_Timeout(P_CMD_TMO ptmo, U32 def_ms);
+extern U32  CmdTmo_Retries(P_CMD_TMO ptmo, U32 def_times);
+extern void CmdTmo_Update(P_CMD_TMO ptmo, U32 pass, U32 attempts, U32 latency_ms);
+extern void CmdTmo_Miss(P_CMD_TMO ptmo, U32 tmo_ms);
+
+#endif
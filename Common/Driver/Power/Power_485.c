@@ -31,9 +31,21 @@ Purpose : PWR for AT91SAM9260-EK and AT91SAM9XE-EK
 
 #define PWRNUM_ONLY_1       1
 #define MAX_VOL_DUT        24000    //DUTѹֵ
+
+#define PWR_STEP_UV         98840       //1ѹֵ0.09884V
+#define PWR_STEP_MAX        80          //80, Լ8V
+#define PWR_ADJ_TRIES       10          //ջ
+#define PWR_SETTLE_MS       20          //ںȴȶ
+#define PWR_OFS_MAGIC       0x3153464F  //"OFS1"
+
 const U8 TurnOnData[]  = "01";
 const U8 TurnOffData[] = "00";
 
+//ÿĿѹʱۼƲ, ڱξߵNAND, һDUT￪ʼ
+static PWR_OFS PwrOfsTab[PWR_OFS_MAX];
+static BOOL PwrOfsDirty = FALSE;
+static S32 PwrSteps = 0;            //ϴ趨ѹۼƵڵĲ
+
 /**************************************************************************** 
 : Hex2Str32 
 : ʮתַ 
@@ -72,7 +84,16 @@ static BOOL PWR_ReadCmd(U8 func, U8 reg, U8 * ReadStr)
 ******************************************************************************/
 BOOL PWR_TurnOnDut(void)
 {
-    return(PWR_WriteCmd(PWRFUNC_ON_OFF_DUT, PWRCHAN_DUT, (U8 * )TurnOnData));
+    if(PWRMON_Armed())  //INRUSH_Tʱϵʼ¼
+    {
+        PWRMON_Start();
+    }
+    if(PWR_WriteCmd(PWRFUNC_ON_OFF_DUT, PWRCHAN_DUT, (U8 * )TurnOnData) == FALSE)
+    {
+        PWRMON_Stop();
+        return(FALSE);
+    }
+    return(TRUE);
 }
 /******************************************************************************
     : PWR_TurnOffDut
@@ -82,6 +103,7 @@ BOOL PWR_TurnOnDut(void)
 ******************************************************************************/
 BOOL PWR_TurnOffDut(void)
 {
+    PWRMON_Stop();
     return(PWR_WriteCmd(PWRFUNC_ON_OFF_DUT, PWRCHAN_DUT, (U8 * )TurnOffData));
 }
 /******************************************************************************
@@ -120,6 +142,7 @@ BOOL PWR_SetDutVolt(U32 volt)
     }
     Hex2Str32(VoltStr, volt);//תASCII
  
+    PwrSteps = 0;
     return(PWR_WriteCmd(PWRFUNC_SET_VOLT, PWRCHAN_DUT, (U8 * )VoltStr));//õѹ
 }
 
@@ -163,7 +186,12 @@ BOOL PWR_AddDutVolt(U32 Stepval)
     U8 VoltStr[6];
 
     Hex2Str32(VoltStr, Stepval);//תASCII
-    return(PWR_WriteCmd(PWRFUNC_VOL_ADD, PWRCHAN_DUT, (U8 * )VoltStr));//͵ڵԴѹ
+    if(PWR_WriteCmd(PWRFUNC_VOL_ADD, PWRCHAN_DUT, (U8 * )VoltStr) == FALSE)//͵ڵԴѹ
+    {
+        return(FALSE);
+    }
+    PwrSteps += Stepval;
+    return(TRUE);
 }
 /******************************************************************************
     : PWR_SubDutVolt
@@ -177,6 +205,205 @@ BOOL PWR_SubDutVolt(U32 Stepval)
     U8 VoltStr[6];
 
     Hex2Str32(VoltStr, Stepval);//תASCII
-    return(PWR_WriteCmd(PWRFUNC_VOL_SUB, PWRCHAN_DUT, (U8 * )VoltStr));//͵ڵԴѹ½
+    if(PWR_WriteCmd(PWRFUNC_VOL_SUB, PWRCHAN_DUT, (U8 * )VoltStr) == FALSE)//͵ڵԴѹ½
+    {
+        return(FALSE);
+    }
+    PwrSteps -= Stepval;
+    return(TRUE);
+}
+
+static BOOL PWR_MoveSteps(S32 steps)
+{
+    if(steps > PWR_STEP_MAX)
+    {
+        steps = PWR_STEP_MAX;
+    }
+    if(steps < -PWR_STEP_MAX)
+    {
+        steps = -PWR_STEP_MAX;
+    }
+
+    if(steps > 0)
+    {
+        return(PWR_AddDutVolt(steps));
+    }
+    if(steps < 0)
+    {
+        return(PWR_SubDutVolt(-steps));
+    }
+    return(TRUE);
+}
+
+static P_PWR_OFS PWR_OfsGet(U32 target)
+{
+    U32 i;
+    P_PWR_OFS pfree = NULL;
+
+    for(i = 0; i < PWR_OFS_MAX; i++)
+    {
+        if(PwrOfsTab[i].target == target)
+        {
+            return(&PwrOfsTab[i]);
+        }
+        if(PwrOfsTab[i].target == 0 && pfree == NULL)
+        {
+            pfree = &PwrOfsTab[i];
+        }
+    }
+
+    if(pfree == NULL)       //, һ
+    {
+        pfree = &PwrOfsTab[PWR_OFS_MAX - 1];
+    }
+    pfree->target = target;
+    pfree->steps  = 0;
+    return(pfree);
+}
+
+/******************************************************************************
+    : PWR_AdjustDutVolt
+      : target Ŀѹ mV, tol  mV, chn õADͨ,
+            pVolt һβõĵѹ mV
+ֵ    : PASS/FAIL
+  : ջDUTѹ. ͲѹҪĲ(), ʵ
+            ÿѹֵ; һĿ걻λ֮͸ö, 
+            λֻһԴﲻҪʧ. ±Ŀѹۼ
+            , Դ趨һεߵλ.
+******************************************************************************/
+U32 PWR_AdjustDutVolt(U32 target, U32 tol, U32 chn, U32 * pVolt)
+{
+    U32 i;
+    S32 volt = 0, err, next;
+    S32 lo = 0, hi = 0;
+    BOOL haveLo = FALSE, haveHi = FALSE;
+    S32 voltPrev = 0, posPrev = 0;
+    S32 gain = PWR_STEP_UV, slope;
+    P_PWR_OFS pofs;
+    U32 res = FAIL;
+
+    pofs = PWR_OfsGet(target);
+    if(PwrSteps == 0 && pofs->steps)
+    {
+        PWR_MoveSteps(pofs->steps);
+        OS_Delay(PWR_SETTLE_MS);
+    }
+
+    for(i = 0; i < PWR_ADJ_TRIES; i++)
+    {
+        volt = (S32)AD_MeasureChannel(chn, target, PRECISION_12BIT);
+        err  = (S32)target - volt;
+        Dprintf("PWR %d steps: %dmV\r\n", PwrSteps, volt);
+
+        if(err < (S32)tol && err > -(S32)tol)
+        {
+            res = PASS;
+            break;
+        }
+
+        //ʵÿѹ, ƫһΪ, 
+        if(i && PwrSteps != posPrev)
+        {
+            slope = (volt - voltPrev) * 1000 / (PwrSteps - posPrev);
+            if(slope > PWR_STEP_UV / 2 && slope < PWR_STEP_UV * 2)
+            {
+                gain = slope;
+            }
+        }
+
+        if(err > 0)
+        {
+            lo = PwrSteps;
+            haveLo = TRUE;
+        }
+        else
+        {
+            hi = PwrSteps;
+            haveHi = TRUE;
+        }
+
+        next = PwrSteps + (err * 1000 + ((err > 0) ? gain / 2 : -gain / 2)) / gain;
+        if(haveLo && haveHi)
+        {
+            if(hi - lo <= 1)        //ֱʲ
+            {
+                break;
+            }
+            if(next <= lo || next >= hi)
+            {
+                next = (lo + hi) / 2;
+            }
+        }
+        if(next == PwrSteps)
+        {
+            next += (err > 0) ? 1 : -1;
+        }
+
+        voltPrev = volt;
+        posPrev  = PwrSteps;
+        if(PWR_MoveSteps(next - PwrSteps) == FALSE)
+        {
+            break;
+        }
+        OS_Delay(PWR_SETTLE_MS);
+    }
+
+    if(res == PASS && pofs->steps != PwrSteps)
+    {
+        pofs->steps = PwrSteps;
+        PwrOfsDirty = TRUE;
+    }
+    *pVolt = (U32)volt;
+    return(res);
+}
+
+/******************************************************************************
+    : PWR_OfsInit
+      : void
+ֵ    : void
+  : 뱾ξ߼¼ĵѹλ
+******************************************************************************/
+void PWR_OfsInit(void)
+{
+    FS_FILE *fb;
+    U32 magic = 0;
+
+    memset(PwrOfsTab, 0, sizeof(PwrOfsTab));
+    if(fb = FS_FOpen(PWR_OFS_FILE,"rb"))
+    {
+        FS_FRead(&magic, sizeof(magic), 1, fb);
+        if(magic != PWR_OFS_MAGIC || FS_FRead(PwrOfsTab, sizeof(PwrOfsTab), 1, fb) != 1)
+        {
+            memset(PwrOfsTab, 0, sizeof(PwrOfsTab));
+        }
+        FS_FClose(fb);
+    }
+    PwrOfsDirty = FALSE;
+}
+
+/******************************************************************************
+    : PWR_OfsSave
+      : void
+ֵ    : void
+  : λб仯ʱ
+******************************************************************************/
+void PWR_OfsSave(void)
+{
+    FS_FILE *fb;
+    U32 magic = PWR_OFS_MAGIC;
+
+    if(PwrOfsDirty == FALSE)
+    {
+        return;
+    }
+
+    if(fb = FS_FOpen(PWR_OFS_FILE,"wb"))
+    {
+        FS_FWrite(&magic, sizeof(magic), 1, fb);
+        FS_FWrite(PwrOfsTab, sizeof(PwrOfsTab), 1, fb);
+        FS_SetEndOfFile(fb);
+        FS_FClose(fb);
+        PwrOfsDirty = FALSE;
+    }
 }
 
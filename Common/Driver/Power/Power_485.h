@@ -18,6 +18,16 @@
 
 #include "includes.h"
 
+#define PWR_OFS_MAX         (8)             //¼Ŀѹ
+#define PWR_OFS_FILE        "PwrOfs.bin"
+
+typedef struct
+{
+    U32 target;                     //Ŀѹ mV, 0Ϊ
+    S32 steps;                      //ʱ趨ѹĲ
+
+} PWR_OFS, * P_PWR_OFS;
+
 extern BOOL PWR_TurnOnDut(void);
 extern BOOL PWR_TurnOffDut(void);
 extern BOOL PWR_TurnOnAux(void);
@@ -27,4 +37,7 @@ extern BOOL PWR_SetAuxVolt(U32 volt);
 extern BOOL PWR_GetDUTCur(U32 *pCur);
 extern BOOL PWR_AddDutVolt(U32 Stepval);
 extern BOOL PWR_SubDutVolt(U32 Stepval);
+extern U32  PWR_AdjustDutVolt(U32 target, U32 tol, U32 chn, U32 * pVolt);
+extern void PWR_OfsInit(void);
+extern void PWR_OfsSave(void);
 #endif//_PWR_H_
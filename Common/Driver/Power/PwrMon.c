@@ -0,0 +1,163 @@
+/*******************************************************************************
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+    File name:  PwrMon.c
+    Function: DUT supply current monitor
+    IDE:    IAR EWARM V6.4
+    ICE:    J-Link
+    BOARD:  Merak Main board
+    History
+                ver.1.00    First release
+
+    While it runs, a task reads the power board current every
+    PWRMON_PERIOD_MS and keeps the readings with their OS_GetTime32() stamps
+    in a ring. Test items ask for the statistics of a time window: the peak
+    after power on, the mean once settled, the mean after a sleep command.
+
+    The readings share the MERAK bus with the relays, LCD, ExtIO and audio,
+    so the monitor runs only when an item needs it: from power on when the
+    list has an INRUSH_T item (PWRMON_Arm), and during a CURAVG_T item. The
+    task runs below the test task and takes the bus lock for one reading at
+    a time.
+*******************************************************************************/
+#include "includes.h"
+
+#define PWRMON_PRIO         (135)           // below the test task
+#define PWRMON_WAIT_MS      (100)           // a window must be covered by then
+
+typedef struct
+{
+    U32 t;                          // OS_GetTime32() in the middle of the reading
+    U32 ma;
+
+} PWRMON_SMP;
+
+static PWRMON_SMP PwrMonBuf[PWRMON_BUF];
+static volatile U32 PwrMonHead = 0;         // samples written since the start
+static volatile U32 PwrMonGen = 0;          // bumped by every start
+static volatile BOOL PwrMonRun = FALSE;
+static BOOL PwrMonArmed = FALSE;            // start at DUT power on
+static U32 PwrMonOn = 0;
+
+static OS_STACKPTR int Stack_PwrMon[256];
+static OS_TASK TCB_PwrMon;
+
+static void PwrMon_Task(void)
+{
+    U32 ma, t, gen;
+
+    while(1)
+    {
+        if(PwrMonRun)
+        {
+            gen = PwrMonGen;
+            t = OS_GetTime32();
+            if(PWR_GetDUTCur(&ma) && gen == PwrMonGen)   // drop a reading from before a restart
+            {
+                t += (OS_GetTime32() - t) / 2;
+                PwrMonBuf[PwrMonHead % PWRMON_BUF].t  = t;
+                PwrMonBuf[PwrMonHead % PWRMON_BUF].ma = ma;
+                PwrMonHead++;
+            }
+        }
+        OS_Delay(PWRMON_PERIOD_MS);
+    }
+}
+
+/******************************************************************************
+    Routine Name    : PWRMON_Init
+    Parameters      : none
+    Return value    : none
+    Description     : Start the monitor task, it samples only after PWRMON_Start.
+******************************************************************************/
+void PWRMON_Init(void)
+{
+    OS_CREATETASK(&TCB_PwrMon, "PwrMon Task", PwrMon_Task, PWRMON_PRIO, Stack_PwrMon);
+}
+
+/******************************************************************************
+    Routine Name    : PWRMON_Start
+    Parameters      : none
+    Return value    : none
+    Description     : Clear the ring and sample, called when the DUT supply
+                      is turned on.
+******************************************************************************/
+void PWRMON_Start(void)
+{
+    PwrMonGen++;
+    PwrMonHead = 0;
+    PwrMonOn = OS_GetTime32();
+    PwrMonRun = TRUE;
+}
+
+void PWRMON_Stop(void)
+{
+    PwrMonRun = FALSE;
+}
+
+/******************************************************************************
+    Routine Name    : PWRMON_Arm
+    Parameters      : on, TRUE if the list needs the readings from power on
+    Return value    : none
+    Description     : PWR_TurnOnDut starts the monitor only when armed.
+******************************************************************************/
+void PWRMON_Arm(BOOL on)
+{
+    PwrMonArmed = on;
+}
+
+BOOL PWRMON_Armed(void)
+{
+    return(PwrMonArmed);
+}
+
+BOOL PWRMON_Running(void)
+{
+    return(PwrMonRun);
+}
+
+U32 PWRMON_OnTime(void)
+{
+    return(PwrMonOn);
+}
+
+/******************************************************************************
+    Routine Name    : PWRMON_Window
+    Parameters      : from, to, OS_GetTime32() times, from <= t < to
+                      acc, statistics of the readings in the window, mA
+    Return value    : number of readings in the window
+    Description     : Wait until the window is over and sampled, then collect
+                      it. A window older than PWRMON_BUF readings is partly
+                      lost.
+******************************************************************************/
+U32 PWRMON_Window(U32 from, U32 to, P_STAT_ACC acc)
+{
+    U32 i, n, head;
+    PWRMON_SMP * psmp;
+
+    Stat_Reset(acc);
+
+    // until a reading after the window, or the monitor stops or falls behind
+    while(PwrMonRun && (S32)(OS_GetTime32() - to) < PWRMON_WAIT_MS)
+    {
+        head = PwrMonHead;
+        if(head && (S32)(PwrMonBuf[(head - 1) % PWRMON_BUF].t - to) >= 0)
+        {
+            break;
+        }
+        OS_Delay(PWRMON_PERIOD_MS);
+    }
+
+    head = PwrMonHead;
+    n = (head < PWRMON_BUF) ? head : PWRMON_BUF;
+    for(i = head - n; i != head; i++)
+    {
+        psmp = &PwrMonBuf[i % PWRMON_BUF];
+        if((S32)(psmp->t - from) >= 0 && (S32)(psmp->t - to) < 0)
+        {
+            Stat_Add(acc, (S32)psmp->ma);
+        }
+    }
+    return(acc->n);
+}
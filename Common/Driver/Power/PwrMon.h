@@ -0,0 +1,28 @@
+/*******************************************************************************
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+    File name:  PwrMon.h
+    Function: DUT supply current monitor head file
+    IDE:    IAR EWARM V6.4
+    ICE:    J-Link
+    BOARD:  Merak Main board
+    History
+                ver.1.00    First release
+*******************************************************************************/
+#ifndef _PWRMON_H_
+#define _PWRMON_H_
+
+#define PWRMON_BUF          (1024)          // samples kept, a power of 2
+#define PWRMON_PERIOD_MS    (20)            // pause between two readings
+
+extern void PWRMON_Init(void);
+extern void PWRMON_Start(void);
+extern void PWRMON_Stop(void);
+extern void PWRMON_Arm(BOOL on);
+extern BOOL PWRMON_Armed(void);
+extern BOOL PWRMON_Running(void);
+extern U32  PWRMON_OnTime(void);
+extern U32  PWRMON_Window(U32 from, U32 to, P_STAT_ACC acc);
+
+#endif
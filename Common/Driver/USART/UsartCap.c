@@ -0,0 +1,305 @@
+/******************************************************************************
+    UsartCap.c
+    USART traffic capture
+
+    Copyright(C) 2010, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+
+    Every chunk received or sent through usart2.c on a port in UsartCapMask
+    is kept in a RAM ring with its direction and a PIT cycle stamp. When the
+    ring is full the oldest records are dropped. The ring is exported as a
+    pcap file (LINKTYPE_USER0) to NAND or as a UDP stream, so it can be
+    opened with Wireshark or "tcpdump -r UsartCap.cap -X" on the host. Each
+    packet starts with two bytes: port number and direction (0 rx, 1 tx).
+
+    RX chunks are stamped when the application takes them out of the PDC
+    ring, not when they arrive on the wire.
+******************************************************************************/
+#include "includes.h"
+
+#define CAP_BUF_SIZE        (64 * 1024)
+#define CAP_REC_HEAD        (8)         // cycles(4) + port(1) + dir(1) + len(2)
+#define CAP_REC_DATA_MAX    (256)       // longer chunks are split
+#define CAP_CYCLE_HZ        (6208000)   // OS_GetTime_Cycles() clock, OS_FSYS/2/16, multiple of 8000
+#define CAP_LINKTYPE        (147)       // LINKTYPE_USER0
+#define CAP_UDP_SIZE        (1024)
+
+typedef void (*CAP_SINK)(U8 * pdata, U32 len);
+
+U32 UsartCapMask = 0;
+
+static U8  CapBuf[CAP_BUF_SIZE];
+static U32 CapHead;         // next write position
+static U32 CapTail;         // oldest record
+static U32 CapUsed;
+static U32 CapDropped;
+static U32 CapStartCycles;
+static BOOL CapStarted = FALSE;
+
+static FS_FILE * CapFile;
+static long CapSock;
+static struct sockaddr_in CapAddr;
+static U8  CapUdpBuf[CAP_UDP_SIZE];
+static U32 CapUdpLen;
+
+static void Cap_Put(U8 * pdata, U32 len)
+{
+    while(len--)
+    {
+        CapBuf[CapHead++] = *pdata++;
+        if(CapHead >= CAP_BUF_SIZE)
+            CapHead = 0;
+    }
+}
+
+static void Cap_Get(U32 pos, U8 * pdata, U32 len)
+{
+    while(len--)
+    {
+        *pdata++ = CapBuf[pos++];
+        if(pos >= CAP_BUF_SIZE)
+            pos = 0;
+    }
+}
+
+static void Cap_PutU32(U8 * p, U32 v)
+{
+    p[0] = (U8)v;
+    p[1] = (U8)(v >> 8);
+    p[2] = (U8)(v >> 16);
+    p[3] = (U8)(v >> 24);
+}
+
+/******************************************************************************
+    Routine Name    : UsartCap_Start
+    Parameters      : mask, bit n set to capture port n (USART0..USDBGU),
+                      0 for CAP_PORT_DEFAULT
+    Return value    : none
+    Description     : Clear the capture ring and start capturing.
+******************************************************************************/
+void UsartCap_Start(U32 mask)
+{
+    OS_EnterRegion();
+    CapHead = 0;
+    CapTail = 0;
+    CapUsed = 0;
+    CapDropped = 0;
+    CapStartCycles = OS_GetTime_Cycles();
+    CapStarted = TRUE;
+    UsartCapMask = mask ? mask : CAP_PORT_DEFAULT;
+    OS_LeaveRegion();
+}
+
+/******************************************************************************
+    Routine Name    : UsartCap_Stop
+    Parameters      : none
+    Return value    : none
+    Description     : Stop capturing and forget the capture, UsartCap_Save
+                      does nothing until the next UsartCap_Start.
+******************************************************************************/
+void UsartCap_Stop(void)
+{
+    OS_EnterRegion();
+    UsartCapMask = 0;
+    CapStarted = FALSE;
+    OS_LeaveRegion();
+}
+
+/******************************************************************************
+    Routine Name    : UsartCap_Record
+    Parameters      : usart, dir, pdata, len
+    Return value    : none
+    Description     : Add one chunk to the ring, dropping the oldest records
+                      when there is no room. Called through USART_CAP().
+******************************************************************************/
+void UsartCap_Record(U32 usart, U32 dir, U8 * pdata, U32 len)
+{
+    U8 head[CAP_REC_HEAD];
+    U32 n, cycles;
+
+    cycles = OS_GetTime_Cycles();
+
+    OS_EnterRegion();
+    while(len)
+    {
+        n = (len > CAP_REC_DATA_MAX) ? CAP_REC_DATA_MAX : len;
+
+        while(CapUsed + CAP_REC_HEAD + n > CAP_BUF_SIZE)
+        {
+            U8 old[CAP_REC_HEAD];
+            U32 oldlen;
+
+            Cap_Get(CapTail, old, CAP_REC_HEAD);
+            oldlen = CAP_REC_HEAD + (old[6] | (old[7] << 8));
+            CapTail = (CapTail + oldlen) % CAP_BUF_SIZE;
+            CapUsed -= oldlen;
+            CapDropped++;
+        }
+
+        Cap_PutU32(head, cycles);
+        head[4] = (U8)usart;
+        head[5] = (U8)dir;
+        head[6] = (U8)n;
+        head[7] = (U8)(n >> 8);
+        Cap_Put(head, CAP_REC_HEAD);
+        Cap_Put(pdata, n);
+        CapUsed += CAP_REC_HEAD + n;
+
+        pdata += n;
+        len -= n;
+    }
+    OS_LeaveRegion();
+}
+
+/******************************************************************************
+    Routine Name    : Cap_Export
+    Parameters      : sink
+    Return value    : none
+    Description     : Write the ring as a pcap file, oldest record first.
+                      The cycle stamps are turned into seconds/microseconds
+                      from the capture start; gaps between two records must
+                      be shorter than one cycle counter wrap (about 690 s).
+******************************************************************************/
+static void Cap_Export(CAP_SINK sink)
+{
+    U8 rec[16 + 2 + CAP_REC_DATA_MAX];
+    U8 head[CAP_REC_HEAD];
+    U32 mask, pos, used, n;
+    U32 cycles, last, sec, rem;
+
+    mask = UsartCapMask;
+    UsartCapMask = 0;
+
+    // global header
+    Cap_PutU32(rec, 0xA1B2C3D4);
+    rec[4] = 2; rec[5] = 0;                 // version 2.4
+    rec[6] = 4; rec[7] = 0;
+    Cap_PutU32(rec + 8, 0);                 // thiszone
+    Cap_PutU32(rec + 12, 0);                // sigfigs
+    Cap_PutU32(rec + 16, 2 + CAP_REC_DATA_MAX);
+    Cap_PutU32(rec + 20, CAP_LINKTYPE);
+    sink(rec, 24);
+
+    pos  = CapTail;
+    used = CapUsed;
+    last = CapStartCycles;
+    sec  = 0;
+    rem  = 0;
+    while(used)
+    {
+        Cap_Get(pos, head, CAP_REC_HEAD);
+        cycles = head[0] | (head[1] << 8) | (head[2] << 16) | ((U32)head[3] << 24);
+        n = head[6] | (head[7] << 8);
+
+        rem += cycles - last;
+        last = cycles;
+        while(rem >= CAP_CYCLE_HZ)
+        {
+            rem -= CAP_CYCLE_HZ;
+            sec++;
+        }
+
+        Cap_PutU32(rec, sec);
+        Cap_PutU32(rec + 4, rem * 125 / (CAP_CYCLE_HZ / 8000));
+        Cap_PutU32(rec + 8, 2 + n);
+        Cap_PutU32(rec + 12, 2 + n);
+        rec[16] = head[4];
+        rec[17] = head[5];
+        Cap_Get((pos + CAP_REC_HEAD) % CAP_BUF_SIZE, rec + 18, n);
+        sink(rec, 18 + n);
+
+        pos = (pos + CAP_REC_HEAD + n) % CAP_BUF_SIZE;
+        used -= CAP_REC_HEAD + n;
+    }
+
+    if(CapDropped)
+    {
+        Dprintf("UsartCap: %d records dropped\r\n", CapDropped);
+    }
+    UsartCapMask = mask;
+}
+
+static void Cap_FileSink(U8 * pdata, U32 len)
+{
+    FS_FWrite(pdata, 1, len, CapFile);
+}
+
+static void Cap_UdpFlush(void)
+{
+    if(CapUdpLen)
+    {
+        sendto(CapSock, (char *)CapUdpBuf, CapUdpLen, 0, (struct sockaddr *)&CapAddr, sizeof(CapAddr));
+        CapUdpLen = 0;
+        OS_Delay(1);    // pace the stream, the host side is a plain UDP listener
+    }
+}
+
+static void Cap_UdpSink(U8 * pdata, U32 len)
+{
+    if(CapUdpLen + len > CAP_UDP_SIZE)
+    {
+        Cap_UdpFlush();
+    }
+    memcpy(CapUdpBuf + CapUdpLen, pdata, len);
+    CapUdpLen += len;
+}
+
+/******************************************************************************
+    Routine Name    : UsartCap_Save
+    Parameters      : none
+    Return value    : TRUE/FALSE
+    Description     : Write the capture to CAP_FILE on NAND.
+******************************************************************************/
+BOOL UsartCap_Save(void)
+{
+    if(CapStarted == FALSE)
+    {
+        return(FALSE);
+    }
+
+    if(CapFile = FS_FOpen(CAP_FILE, "wb"))
+    {
+        Cap_Export(Cap_FileSink);
+        FS_SetEndOfFile(CapFile);
+        FS_FClose(CapFile);
+        return(TRUE);
+    }
+    return(FALSE);
+}
+
+/******************************************************************************
+    Routine Name    : UsartCap_Send
+    Parameters      : ip_addr
+    Return value    : TRUE/FALSE
+    Description     : Send the capture as a UDP stream to ip_addr:CAP_UDP_PORT,
+                      e.g. received with "nc -u -l 5804 > UsartCap.cap".
+******************************************************************************/
+BOOL UsartCap_Send(U32 ip_addr)
+{
+    if(CapStarted == FALSE)
+    {
+        return(FALSE);
+    }
+
+    CapSock = socket(AF_INET, SOCK_DGRAM, 0);
+    if(CapSock < 0)
+    {
+        return(FALSE);
+    }
+
+    memset(&CapAddr, 0, sizeof(CapAddr));
+    CapAddr.sin_family      = AF_INET;
+    CapAddr.sin_port        = htons(CAP_UDP_PORT);
+    CapAddr.sin_addr.s_addr = htonl(ip_addr);
+    CapUdpLen = 0;
+
+    Cap_Export(Cap_UdpSink);
+    Cap_UdpFlush();
+
+    closesocket(CapSock);
+    return(TRUE);
+}
@@ -0,0 +1,39 @@
+/******************************************************************************
+    UsartCap.h
+    USART traffic capture
+
+    Copyright(C) 2010, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+******************************************************************************/
+#ifndef _USART_CAP_H_
+#define _USART_CAP_H_
+
+#define CAP_DIR_RX          0
+#define CAP_DIR_TX          1
+
+// MERAK, DUT and AUX ports
+#define CAP_PORT_DEFAULT    ((1 << USART0) | (1 << USART1) | (1 << USART2))
+
+#define CAP_FILE            "UsartCap.cap"
+#define CAP_UDP_PORT        5804
+
+extern U32 UsartCapMask;
+
+// Hook for usart2.c, only one test when the capture is off.
+#define USART_CAP(usart, dir, pdata, len)                   \
+    do {                                                    \
+        if(UsartCapMask & (1 << (usart)))                   \
+            UsartCap_Record((usart), (dir), (pdata), (len));\
+    } while(0)
+
+extern void UsartCap_Start(U32 mask);
+extern void UsartCap_Stop(void);
+extern void UsartCap_Record(U32 usart, U32 dir, U8 * pdata, U32 len);
+extern BOOL UsartCap_Save(void);
+extern BOOL UsartCap_Send(U32 ip_addr);
+
+#endif
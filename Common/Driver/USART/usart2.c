@@ -8,6 +8,9 @@
 
     History
     2010.03.04  ver.2.00    First release by chenli
+                ver.2.10    All ports are described by UsartPortTab, the API
+                            functions work on the port descriptor
+                ver.2.20    RX/TX chunks go to the capture ring, see UsartCap.c
 ******************************************************************************/
 #include "includes.h"
 
@@ -15,26 +18,56 @@
 
 #define RTOS
 
-// USART buffer and point
-INT8U   US0_rx_buf[US0_RX_BUF_MAX];
-INT8U   US0_tx_buf[US0_TX_BUF_MAX];
-INT32U  US0RxOutPtr;
+#define US_PORT_MAX     (USDBGU + 1)
 
-INT8U   US1_rx_buf[US1_RX_BUF_MAX];
-INT8U   US1_tx_buf[US1_TX_BUF_MAX];
-INT32U  US1RxOutPtr;
+#define US_ERR_MASK     (AT91C_US_OVRE | AT91C_US_FRAME | AT91C_US_PARE)
 
-INT8U   US2_rx_buf[US2_RX_BUF_MAX];
-INT8U   US2_tx_buf[US2_TX_BUF_MAX];
-INT32U  US2RxOutPtr;
+// , һڵļĴ, ܽ, , ָ, úͳƶ
+typedef struct _USART_PORT {
+    AT91PS_USART us;        // Ĵ, DBGU ļĴUSART
+    AT91PS_PIO   pio;       // TXD/RXD ܽ
+    INT32U       pins;
+    AT91PS_PIO   rts_pio;   // RS485 ģʽRTSܽ
+    INT32U       rts_pin;
+    INT32U       id;        // ID
+    INT8U       *rx_buf;
+    INT32U       rx_size;
+    INT8U       *tx_buf;
+    INT32U       tx_size;
+    INT32U       rx_outptr; // ջBUFȡָ
+    USART_CONFIG config;
+    USART_STAT   stat;
+} USART_PORT;
 
-INT8U   US3_rx_buf[US3_RX_BUF_MAX];
-INT8U   US3_tx_buf[US3_TX_BUF_MAX];
-INT32U  US3RxOutPtr;
+// USART buffer
+static INT8U   US0_rx_buf[US0_RX_BUF_MAX];
+static INT8U   US0_tx_buf[US0_TX_BUF_MAX];
 
-INT8U   USDBGU_rx_buf[USDBGU_RX_BUF_MAX];
-INT8U   USDBGU_tx_buf[USDBGU_TX_BUF_MAX];
-INT32U  USDBGURxOutPtr;
+static INT8U   US1_rx_buf[US1_RX_BUF_MAX];
+static INT8U   US1_tx_buf[US1_TX_BUF_MAX];
+
+static INT8U   US2_rx_buf[US2_RX_BUF_MAX];
+static INT8U   US2_tx_buf[US2_TX_BUF_MAX];
+
+static INT8U   US3_rx_buf[US3_RX_BUF_MAX];
+static INT8U   US3_tx_buf[US3_TX_BUF_MAX];
+
+static INT8U   USDBGU_rx_buf[USDBGU_RX_BUF_MAX];
+static INT8U   USDBGU_tx_buf[USDBGU_TX_BUF_MAX];
+
+static USART_PORT UsartPortTab[US_PORT_MAX] =
+{
+    {AT91C_BASE_US0, AT91C_BASE_PIOB, AT91C_PIO_PB4  | AT91C_PIO_PB5,  AT91C_BASE_PIOB, AT91C_PIO_PB26, AT91C_ID_US0,
+     US0_rx_buf,    US0_RX_BUF_MAX,    US0_tx_buf,    US0_TX_BUF_MAX},
+    {AT91C_BASE_US1, AT91C_BASE_PIOB, AT91C_PIO_PB6  | AT91C_PIO_PB7,  AT91C_BASE_PIOB, AT91C_PIO_PB28, AT91C_ID_US1,
+     US1_rx_buf,    US1_RX_BUF_MAX,    US1_tx_buf,    US1_TX_BUF_MAX},
+    {AT91C_BASE_US2, AT91C_BASE_PIOB, AT91C_PIO_PB8  | AT91C_PIO_PB9,  AT91C_BASE_PIOA, AT91C_PIO_PA4,  AT91C_ID_US2,
+     US2_rx_buf,    US2_RX_BUF_MAX,    US2_tx_buf,    US2_TX_BUF_MAX},
+    {AT91C_BASE_US3, AT91C_BASE_PIOB, AT91C_PIO_PB10 | AT91C_PIO_PB11, AT91C_BASE_PIOC, AT91C_PIO_PC8,  AT91C_ID_US3,
+     US3_rx_buf,    US3_RX_BUF_MAX,    US3_tx_buf,    US3_TX_BUF_MAX},
+    {(AT91PS_USART)AT91C_BASE_DBGU, AT91C_BASE_PIOB, AT91C_PIO_PB14 | AT91C_PIO_PB15, NULL, 0, AT91C_ID_SYS,
+     USDBGU_rx_buf, USDBGU_RX_BUF_MAX, USDBGU_tx_buf, USDBGU_TX_BUF_MAX},
+};
 
 // public functions
 //driver
@@ -52,8 +85,109 @@ BOOL    UsartPutStr(INT32U usart, INT8U *pstr);
 BOOL    UsartPutFrame(INT32U usart, INT8U *pstr, INT32U length);
 BOOL    UsartSendFrameStart(INT32U usart, INT8U *pstr, INT32U length);
 INT32U  UsartSendFrameCallback(INT32U usart, INT32U *unsendcount);
+BOOL    UsartSendFrameQueue(INT32U usart, INT8U *pframe, INT32U length);
 
 INT32U Dprintf(char *lpszFormat, ...);
+
+/*
+********************************************************************************
+                            ڲ
+********************************************************************************
+*/
+static USART_PORT * Usart_GetPort(INT32U usart)
+{
+    if(usart >= US_PORT_MAX)
+        return NULL;
+
+    return &UsartPortTab[usart];
+}
+
+#define Usart_PortNum(port)     ((INT32U)((port) - UsartPortTab))
+
+// ȷǰջBUFĽָ
+static INT32U Usart_RxInPtr(USART_PORT *port)
+{
+    INT32U rxinptr;
+
+    rxinptr = port->rx_size - port->us->US_RCR;
+    if(rxinptr >= port->rx_size)
+        rxinptr = 0;
+
+    return rxinptr;
+}
+
+// BUFﻹûȡֽ
+static INT32U Usart_RxCount(USART_PORT *port, INT32U rxinptr)
+{
+    if(rxinptr >= port->rx_outptr)
+        return rxinptr - port->rx_outptr;
+
+    return port->rx_size - port->rx_outptr + rxinptr;
+}
+
+// һ֡COPY֡BUF, BUFռ, ȡָ
+static void Usart_CopyOut(USART_PORT *port, INT8U *pframe, INT32U count, INT32U frame_buf_size)
+{
+    INT32U i;
+
+    for(i = 0; i < count; i ++)
+    {
+        pframe[i] = port->rx_buf[port->rx_outptr++];
+        if(port->rx_outptr >= port->rx_size)
+            port->rx_outptr = 0;
+    }
+    for(i = count; i < frame_buf_size; i ++)
+    {
+        pframe[i] = 0;
+    }
+    port->stat.rx_bytes += count;
+
+    USART_CAP(Usart_PortNum(port), CAP_DIR_RX, pframe, count);
+}
+
+// PDCTX_BUF, ȴ
+static void Usart_PdcSend(USART_PORT *port, INT32U length)
+{
+    port->us->US_TPR  = (INT32U) port->tx_buf;
+    port->us->US_TCR  = length;
+
+    //ʹPDC tx
+    port->us->US_PTCR = AT91C_PDC_TXTEN;
+
+    //ȴ
+    while( !((port->us->US_CSR) & AT91C_US_ENDTX) );
+
+    port->stat.tx_bytes += length;
+
+    USART_CAP(Usart_PortNum(port), CAP_DIR_TX, port->tx_buf, length);
+}
+
+// ENDRX ж, BUFͷʼ; ͬʱͳƽմ
+static void Usart_RxIsr(USART_PORT *port)
+{
+    INT32U csr;
+
+    csr = port->us->US_CSR;
+
+    if(csr & AT91C_US_ENDRX)
+    {
+         // ʼPDC
+        port->us->US_RPR = (INT32U) port->rx_buf;
+        port->us->US_RCR = port->rx_size;
+        port->stat.rx_wraps++;
+    }
+    if(csr & US_ERR_MASK)
+    {
+        if(csr & AT91C_US_OVRE)
+            port->stat.overrun++;
+        if(csr & AT91C_US_FRAME)
+            port->stat.frame_err++;
+        if(csr & AT91C_US_PARE)
+            port->stat.parity_err++;
+        port->us->US_CR = AT91C_US_RSTSTA;
+    }
+}
+
 /*
 ********************************************************************************
                             UsartInit
@@ -77,10 +211,11 @@ return: TRUE
 */
 BOOL UsartInit(USART_CONFIG usart, INT32U masterclock)
 {
-    AT91S_USART *us;
+    USART_PORT *port;
+    AT91PS_USART us;
 
     //Բж
-    if (usart.usartport == 4)  // DBGU òУ
+    if (usart.usartport == USDBGU)  // DBGU òУ
     {
         if( (usart.usartmode != 0) | (usart.databit != 3) | (usart.parity > 7)
              | (usart.stopbit != 0) | (usart.baudrate > 115200) )
@@ -95,119 +230,48 @@ BOOL UsartInit(USART_CONFIG usart, INT32U masterclock)
             return (FALSE);
     }
 
-    switch ( usart.usartport )
-    {
-        case USART0:
-            //initial pins
-            AT91C_BASE_PIOB->PIO_PDR = AT91C_PIO_PB4 | AT91C_PIO_PB5;
-            AT91C_BASE_PIOB->PIO_ASR = AT91C_PIO_PB4 | AT91C_PIO_PB5;
-
-            if (usart.usartmode)  //RS485 ģʽʼRTS
-            {
-                AT91C_BASE_PIOB->PIO_PDR = AT91C_PIO_PB26;
-                AT91C_BASE_PIOB->PIO_ASR = AT91C_PIO_PB26;
-            }
-
-            //enable PMC clock
-            AT91C_BASE_PMC->PMC_PCER |= (1 << AT91C_ID_US0);
-
-            us = AT91C_BASE_US0;
-            //initial usart buf point
-            US0RxOutPtr = 0;
-
-            break;
-
-        case USART1:
-             //initial pins
-            AT91C_BASE_PIOB->PIO_PDR = AT91C_PIO_PB6 | AT91C_PIO_PB7;
-            AT91C_BASE_PIOB->PIO_ASR = AT91C_PIO_PB6 | AT91C_PIO_PB7;
-
-            if (usart.usartmode)  //RS485 ģʽʼRTS
-            {
-                AT91C_BASE_PIOB->PIO_PDR = AT91C_PIO_PB28;
-                AT91C_BASE_PIOB->PIO_ASR = AT91C_PIO_PB28;
-            }
-
-            //enable PMC clock
-            AT91C_BASE_PMC->PMC_PCER |= (1 << AT91C_ID_US1);
-
-            us = AT91C_BASE_US1;
-
-            //initial usart buf point
-            US1RxOutPtr = 0;
-
-            break;
-
-        case USART2:
-             //initial pins
-            AT91C_BASE_PIOB->PIO_PDR = AT91C_PIO_PB8 | AT91C_PIO_PB9;
-            AT91C_BASE_PIOB->PIO_ASR = AT91C_PIO_PB8 | AT91C_PIO_PB9;
-
-            if (usart.usartmode)  //RS485 ģʽʼRTS
-            {
-                AT91C_BASE_PIOA->PIO_PDR = AT91C_PIO_PA4;
-                AT91C_BASE_PIOA->PIO_ASR = AT91C_PIO_PA4;
-            }
-
-             //enable PMC clock
-            AT91C_BASE_PMC->PMC_PCER |= (1 << AT91C_ID_US2);
-
-            us = AT91C_BASE_US2;
-
-            //initial usart point
-            US2RxOutPtr = 0;
-
-            break;
-
-        case USART3:
-             //initial pins
-            AT91C_BASE_PIOB->PIO_PDR = AT91C_PIO_PB10 | AT91C_PIO_PB11;
-            AT91C_BASE_PIOB->PIO_ASR = AT91C_PIO_PB10 | AT91C_PIO_PB11;
-
-            if (usart.usartmode)  //RS485 ģʽʼRTS
-            {
-                AT91C_BASE_PIOC->PIO_PDR = AT91C_PIO_PC8;
-                AT91C_BASE_PIOC->PIO_ASR = AT91C_PIO_PC8;
-            }
-
-             //enable PMC clock
-            AT91C_BASE_PMC->PMC_PCER |= (1 << AT91C_ID_US3);
-
-            us = AT91C_BASE_US3;
-
-            //initial usart point
-            US3RxOutPtr = 0;
+    port = Usart_GetPort(usart.usartport);
+    if(port == NULL)
+        return FALSE;
 
-            break;
+    us = port->us;
 
-        case USDBGU:
-             //initial pins
-            AT91C_BASE_PIOB->PIO_PDR = AT91C_PIO_PB15 | AT91C_PIO_PB14;
-            AT91C_BASE_PIOB -> PIO_ASR = AT91C_PIO_PB15 | AT91C_PIO_PB14;
+    //initial pins
+    port->pio->PIO_PDR = port->pins;
+    port->pio->PIO_ASR = port->pins;
 
-             //enable PMC clock
-             //  AT91C_BASE_PMC->PMC_PCER   = 1 << AT91C_ID_SYS; //ϵͳĬΪ
+    //initial usart buf point
+    port->rx_outptr = 0;
+    port->config    = usart;
 
-            AT91C_BASE_DBGU->DBGU_CR   = AT91C_US_RSTSTA | AT91C_US_RSTRX | AT91C_US_RSTTX;
+    if (usart.usartport == USDBGU)
+    {
+         //enable PMC clock
+         //  AT91C_BASE_PMC->PMC_PCER   = 1 << AT91C_ID_SYS; //ϵͳĬΪ
 
-            // Configure baudrate
-            AT91C_BASE_DBGU->DBGU_BRGR =  (masterclock / usart.baudrate) / 16;
+        us->US_CR   = AT91C_US_RSTSTA | AT91C_US_RSTRX | AT91C_US_RSTTX;
 
-            // Configure mode
-            AT91C_BASE_DBGU->DBGU_MR   = AT91C_US_CHMODE_NORMAL | ((usart.parity) << 9);
+        // Configure baudrate
+        us->US_BRGR = (masterclock / usart.baudrate) / 16;
 
-            //enable transmition
-            AT91C_BASE_DBGU->DBGU_CR   = AT91C_US_RXEN | AT91C_US_TXEN;
+        // Configure mode
+        us->US_MR   = AT91C_US_CHMODE_NORMAL | ((usart.parity) << 9);
 
-            //initial usart point
-            USDBGURxOutPtr = 0;
+        //enable transmition
+        us->US_CR   = AT91C_US_RXEN | AT91C_US_TXEN;
 
-            return (TRUE);
+        return (TRUE);
+    }
 
-        default:
-            return FALSE;
+    if (usart.usartmode)  //RS485 ģʽʼRTS
+    {
+        port->rts_pio->PIO_PDR = port->rts_pin;
+        port->rts_pio->PIO_ASR = port->rts_pin;
     }
 
+    //enable PMC clock
+    AT91C_BASE_PMC->PMC_PCER |= (1 << port->id);
+
     // Reset and disable receiver & transmitter
     us->US_CR = AT91C_US_RSTRX | AT91C_US_RSTTX
                 | AT91C_US_RXDIS | AT91C_US_TXDIS;
@@ -242,80 +306,36 @@ return:  TRUE,
 */
 BOOL  UsartRecvStart(INT32U usart)
 {
-    INT32U i, bufmax;
-    AT91S_USART *us;
-    INT8U *pbuf;
-
-    if(usart == USDBGU)
-    {
-        // clear buffer
-        for(i = 0; i < USDBGU_RX_BUF_MAX; i ++)
-        {
-            USDBGU_rx_buf[i] = 0;
-        }
-         //رPDC
-        AT91C_BASE_DBGU->DBGU_PTCR = AT91C_PDC_RXTDIS;
-
-        // ʼPDC
-        AT91C_BASE_DBGU->DBGU_RPR = (INT32U) USDBGU_rx_buf;
-        AT91C_BASE_DBGU->DBGU_RCR = USDBGU_RX_BUF_MAX;
-
-        // ʹж
-        AT91C_BASE_DBGU->DBGU_IER = ((unsigned int) 0x1 <<  3);// ENDRX
-
-        //ʹPDC
-        AT91C_BASE_DBGU->DBGU_PTCR =  AT91C_PDC_RXTEN;
+    INT32U i;
+    USART_PORT *port;
 
-        return TRUE;
-    }
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return FALSE;
 
-    switch(usart)
-    {
-        case USART0:
-            pbuf   = US0_rx_buf;
-            bufmax = US0_RX_BUF_MAX;
-            us     = AT91C_BASE_US0;
-            break;
-
-        case USART1:
-            pbuf   = US1_rx_buf;
-            bufmax = US1_RX_BUF_MAX;
-            us     = AT91C_BASE_US1;
-            break;
-
-        case USART2:
-            pbuf   = US2_rx_buf;
-            bufmax = US2_RX_BUF_MAX;
-            us     = AT91C_BASE_US2;
-            break;
-
-        case USART3:
-            pbuf   = US3_rx_buf;
-            bufmax = US3_RX_BUF_MAX;
-            us     = AT91C_BASE_US3;
-            break;
-
-        default : return FALSE;
-    }
     //clear buffer
-    for(i = 0; i < bufmax; i ++)
+    for(i = 0; i < port->rx_size; i ++)
     {
-        pbuf[i] = 0;
+        port->rx_buf[i] = 0;
     }
+    port->rx_outptr = 0;
+
     //رPDC
-    us->US_PTCR = AT91C_PDC_RXTDIS;
+    port->us->US_PTCR = AT91C_PDC_RXTDIS;
 
     // ʼPDC
-    us->US_RPR = (INT32U)pbuf;
-    us->US_RCR = bufmax;
+    port->us->US_RPR = (INT32U)port->rx_buf;
+    port->us->US_RCR = port->rx_size;
 
-    // ʹж
-    us->US_IER = ((unsigned int) 0x1 <<  3);// ENDRX
+    // ʹж, DBGU ûаװжϴ, 򿪴ж
+    if(usart == USDBGU)
+        port->us->US_IER = AT91C_US_ENDRX;
+    else
+        port->us->US_IER = AT91C_US_ENDRX | US_ERR_MASK;
 
     //ʹPDC
-    us->US_PTCR =  AT91C_PDC_RXTEN;
+    port->us->US_PTCR =  AT91C_PDC_RXTEN;
 
-    //ж
     return TRUE;
 }
 
@@ -333,50 +353,18 @@ return:TRUE/FALSE
 */
 BOOL  UsartRecvReset(INT32U usart)
 {
-    switch(usart)
-    {
-        case USART0:
-            // init rx ring buffer points
-            US0RxOutPtr = 0;
-            //init PDC
-            AT91C_BASE_US0->US_RPR = (INT32U)US0_rx_buf;
-            AT91C_BASE_US0->US_RCR = US0_RX_BUF_MAX;
-            break;
-
-        case USART1:
-            // init rx ring buffer points
-            US1RxOutPtr = 0;
-            //init PDC
-            AT91C_BASE_US1->US_RPR = (INT32U)US1_rx_buf;
-            AT91C_BASE_US1->US_RCR = US1_RX_BUF_MAX;
-            break;
-
-        case USART2:
-            // init rx ring buffer points
-            US2RxOutPtr = 0;
-            //init PDC
-            AT91C_BASE_US2->US_RPR = (INT32U)US2_rx_buf;
-            AT91C_BASE_US2->US_RCR = US2_RX_BUF_MAX;
-            break;
-
-        case USART3:
-            // init rx ring buffer points
-            US3RxOutPtr = 0;
-            //init PDC
-            AT91C_BASE_US3->US_RPR = (INT32U)US3_rx_buf;
-            AT91C_BASE_US3->US_RCR = US3_RX_BUF_MAX;
-            break;
-
-        case USDBGU:
-            // init rx ring buffer points
-            USDBGURxOutPtr = 0;
-            //init PDC
-            AT91C_BASE_DBGU->DBGU_RPR = (INT32U)USDBGU_rx_buf;
-            AT91C_BASE_DBGU->DBGU_RCR = USDBGU_RX_BUF_MAX;
-            break;
-
-        default : return FALSE;
-    }
+    USART_PORT *port;
+
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return FALSE;
+
+    // init rx ring buffer points
+    port->rx_outptr = 0;
+    //init PDC
+    port->us->US_RPR = (INT32U)port->rx_buf;
+    port->us->US_RCR = port->rx_size;
+
     return TRUE;
 }
 
@@ -399,65 +387,23 @@ return: RECV_ERR
 */
 INT32U UsartGetChar(INT32U usart,INT8U *recv_char)
 {
-    INT32U bufmax, rxinptr;
-    INT8U  *pbuf;
-    INT32U *rxoutptr;
+    USART_PORT *port;
 
-    if( recv_char == NULL )
+    port = Usart_GetPort(usart);
+    if( (recv_char == NULL) || (port == NULL) )
         return PARAMETER_ERR;
 
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_rx_buf;
-            bufmax   = US0_RX_BUF_MAX;
-            rxinptr  = US0_RX_BUF_MAX - (AT91C_BASE_US0->US_RCR);
-            rxoutptr = &US0RxOutPtr;
-            break;
-
-        case USART1:
-            pbuf     = US1_rx_buf;
-            bufmax   = US1_RX_BUF_MAX;
-            rxinptr  = US1_RX_BUF_MAX - (AT91C_BASE_US1->US_RCR);
-            rxoutptr = &US1RxOutPtr;
-            break;
-
-        case USART2:
-            pbuf     = US2_rx_buf;
-            bufmax   = US2_RX_BUF_MAX;
-            rxinptr  = US2_RX_BUF_MAX - (AT91C_BASE_US2->US_RCR);
-            rxoutptr = &US2RxOutPtr;
-            break;
-
-        case USART3:
-            pbuf     = US3_rx_buf;
-            bufmax   = US3_RX_BUF_MAX;
-            rxinptr  = US3_RX_BUF_MAX - (AT91C_BASE_US3->US_RCR);
-            rxoutptr = &US3RxOutPtr;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_rx_buf;
-            bufmax   = USDBGU_RX_BUF_MAX;
-            rxinptr  = USDBGU_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);
-            rxoutptr = &USDBGURxOutPtr;
-            break;
-
-       default: return PARAMETER_ERR;
-    }
-
-    //RXInPtr = US0_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);//ȷǰջBUFĽָ
-    if(rxinptr >= bufmax)
-        rxinptr = 0;
-    if(*rxoutptr == rxinptr)
+    if(port->rx_outptr == Usart_RxInPtr(port))
         return RECV_ERR;
-    else
-    {
-        *recv_char = pbuf[(*rxoutptr)++];
-        if(*rxoutptr >= bufmax)
-            *rxoutptr = 0;
-        return RECV_OK;
-    }
+
+    *recv_char = port->rx_buf[port->rx_outptr++];
+    if(port->rx_outptr >= port->rx_size)
+        port->rx_outptr = 0;
+    port->stat.rx_bytes++;
+
+    USART_CAP(usart, CAP_DIR_RX, recv_char, 1);
+
+    return RECV_OK;
 }
 /*********************************************************************************
                             UsartGetFrame
@@ -479,95 +425,23 @@ return: RECV_ERR
 *********************************************************************************/
 INT32U UsartGetFrame(INT32U usart, INT8U *pframe, INT32U frame_buf_size, INT32U *recv_bytes)
 {
-    INT32U i, recvcount;
-    INT32U ptrtemp, bufmax, rxinptr;
-    INT8U  *pbuf;
-    INT32U *rxoutptr;
+    INT32U recvcount;
+    USART_PORT *port;
 
-    if( (pframe == NULL) || (recv_bytes == NULL) )
+    port = Usart_GetPort(usart);
+    if( (pframe == NULL) || (recv_bytes == NULL) || (port == NULL) )
         return PARAMETER_ERR;
 
-    recvcount = 0;
-
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_rx_buf;
-            bufmax   = US0_RX_BUF_MAX;
-            rxinptr  = US0_RX_BUF_MAX - (AT91C_BASE_US0->US_RCR);
-            rxoutptr = &US0RxOutPtr;
-            break;
-
-        case USART1:
-            pbuf     = US1_rx_buf;
-            bufmax   = US1_RX_BUF_MAX;
-            rxinptr  = US1_RX_BUF_MAX - (AT91C_BASE_US1->US_RCR);
-            rxoutptr = &US1RxOutPtr;
-            break;
-
-        case USART2:
-            pbuf     = US2_rx_buf;
-            bufmax   = US2_RX_BUF_MAX;
-            rxinptr  = US2_RX_BUF_MAX - (AT91C_BASE_US2->US_RCR);
-            rxoutptr = &US2RxOutPtr;
-            break;
-
-        case USART3:
-            pbuf     = US3_rx_buf;
-            bufmax   = US3_RX_BUF_MAX;
-            rxinptr  = US3_RX_BUF_MAX - (AT91C_BASE_US3->US_RCR);
-            rxoutptr = &US3RxOutPtr;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_rx_buf;
-            bufmax   = USDBGU_RX_BUF_MAX;
-            rxinptr  = USDBGU_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);
-            rxoutptr = &USDBGURxOutPtr;
-            break;
-
-       default: return PARAMETER_ERR;
-    }
-    //RXInPtr = US0_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);//ȷǰջBUFĽָ
-    //ptrtemp = RXOutPtr;
-
-    // жûյһ֡
-    ptrtemp = *rxoutptr;
-    if(rxinptr >= bufmax)
-        rxinptr = 0;
-    while(1)
-    {
-        if(ptrtemp == rxinptr)// ûյһ֡
-            break;
-        ptrtemp++;
-        recvcount++;
-        if(ptrtemp >= bufmax)
-            ptrtemp = 0;
-    }
-    
+    recvcount = Usart_RxCount(port, Usart_RxInPtr(port));
 
     //յһ֡ȷ֡BUFǷ
     if(recvcount > frame_buf_size)
         return RECV_FRAME_BUF_FULL;
 
-    // һ֡COPY֡BUF
-    for(i = 0; i < recvcount; i ++)
-    {
-        *(pframe + i) = pbuf[(*rxoutptr)++];
-        if(*rxoutptr >= bufmax)
-            *rxoutptr = 0;
-    }
-    // BUFռ
-    for(i = recvcount; i < frame_buf_size; i ++)
-    {
-         *(pframe + i) = 0;
-    }
-
+    Usart_CopyOut(port, pframe, recvcount, frame_buf_size);
     *recv_bytes = recvcount;
-    // ȡָ
 
     return RECV_OK;
-
 }
 
 /*********************************************************************************
@@ -590,70 +464,26 @@ return: RECV_ERR
 *********************************************************************************/
 INT32U UsartGetFrame_by_1BytesEnd(INT32U usart, INT8U frame_end_char, INT8U *pframe, INT32U frame_buf_size, INT32U *recv_bytes)
 {
-    INT32U i, temp, recvcount;
-    INT32U ptrtemp, bufmax, rxinptr;
-    INT8U  *pbuf;
-    INT32U *rxoutptr;
+    INT32U recvcount;
+    INT32U ptrtemp, rxinptr;
+    INT8U  temp;
+    USART_PORT *port;
 
-    if( (pframe == NULL) || (recv_bytes == NULL) )
+    port = Usart_GetPort(usart);
+    if( (pframe == NULL) || (recv_bytes == NULL) || (port == NULL) )
         return PARAMETER_ERR;
 
-    temp      = 0;
-    recvcount = 0;
-
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_rx_buf;
-            bufmax   = US0_RX_BUF_MAX;
-            rxinptr  = US0_RX_BUF_MAX - (AT91C_BASE_US0->US_RCR);
-            rxoutptr = &US0RxOutPtr;
-            break;
-
-        case USART1:
-            pbuf     = US1_rx_buf;
-            bufmax   = US1_RX_BUF_MAX;
-            rxinptr  = US1_RX_BUF_MAX - (AT91C_BASE_US1->US_RCR);
-            rxoutptr = &US1RxOutPtr;
-            break;
-
-        case USART2:
-            pbuf     = US2_rx_buf;
-            bufmax   = US2_RX_BUF_MAX;
-            rxinptr  = US2_RX_BUF_MAX - (AT91C_BASE_US2->US_RCR);
-            rxoutptr = &US2RxOutPtr;
-            break;
-
-        case USART3:
-            pbuf     = US3_rx_buf;
-            bufmax   = US3_RX_BUF_MAX;
-            rxinptr  = US3_RX_BUF_MAX - (AT91C_BASE_US3->US_RCR);
-            rxoutptr = &US3RxOutPtr;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_rx_buf;
-            bufmax   = USDBGU_RX_BUF_MAX;
-            rxinptr  = USDBGU_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);
-            rxoutptr = &USDBGURxOutPtr;
-            break;
-
-       default: return PARAMETER_ERR;
-    }
-    //RXInPtr = US0_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);//ȷǰջBUFĽָ
-    //ptrtemp = RXOutPtr;
-
     // жûյһ֡
-    ptrtemp = *rxoutptr;
-    if(rxinptr >= bufmax)
-        rxinptr = 0;
+    recvcount = 0;
+    ptrtemp   = port->rx_outptr;
+    rxinptr   = Usart_RxInPtr(port);
     do
     {
         if(ptrtemp == rxinptr)// ûյһ֡
             return RECV_ERR;
-        temp = pbuf[ptrtemp++];
+        temp = port->rx_buf[ptrtemp++];
         recvcount ++;
-        if(ptrtemp >= bufmax)
+        if(ptrtemp >= port->rx_size)
             ptrtemp = 0;
     }
     while(temp != frame_end_char);
@@ -662,24 +492,10 @@ INT32U UsartGetFrame_by_1BytesEnd(INT32U usart, INT8U frame_end_char, INT8U *pfr
     if(recvcount > frame_buf_size)
         return RECV_FRAME_BUF_FULL;
 
-    // һ֡COPY֡BUF
-    for(i = 0; i < recvcount; i ++)
-    {
-        *(pframe + i) = pbuf[(*rxoutptr)++];
-        if(*rxoutptr >= bufmax)
-            *rxoutptr = 0;
-    }
-    // BUFռ
-    for(i = recvcount; i < frame_buf_size; i ++)
-    {
-         *(pframe + i) = 0;
-    }
-
+    Usart_CopyOut(port, pframe, recvcount, frame_buf_size);
     *recv_bytes = recvcount;
-    // ȡָ
 
     return RECV_OK;
-
 }
 
 
@@ -704,109 +520,39 @@ return: RECV_ERR
 *********************************************************************************/
 INT32U UsartGetFrame_by_2BytesEnd(INT32U usart,INT8U frame_end_char1, INT8U frame_end_char2, INT8U *pframe, INT32U frame_buf_size, INT32U *recv_bytes)
 {
-    INT32U i, temp, recvcount;
-    INT32U ptrtemp, bufmax, rxinptr;
-    INT8U  *pbuf;
-    INT32U *rxoutptr;
-
-    temp      = 0;
-    recvcount = 0;
+    INT32U recvcount;
+    INT32U ptrtemp, rxinptr;
+    INT8U  temp, last;
+    USART_PORT *port;
 
-    if( (pframe == NULL) || (recv_bytes == NULL) )
+    port = Usart_GetPort(usart);
+    if( (pframe == NULL) || (recv_bytes == NULL) || (port == NULL) )
         return PARAMETER_ERR;
 
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_rx_buf;
-            bufmax   = US0_RX_BUF_MAX;
-            rxinptr  = US0_RX_BUF_MAX - (AT91C_BASE_US0->US_RCR);
-            rxoutptr = &US0RxOutPtr;
-            break;
-
-        case USART1:
-            pbuf     = US1_rx_buf;
-            bufmax   = US1_RX_BUF_MAX;
-            rxinptr  = US1_RX_BUF_MAX - (AT91C_BASE_US1->US_RCR);
-            rxoutptr = &US1RxOutPtr;
-            break;
-
-        case USART2:
-            pbuf     = US2_rx_buf;
-            bufmax   = US2_RX_BUF_MAX;
-            rxinptr  = US2_RX_BUF_MAX - (AT91C_BASE_US2->US_RCR);
-            rxoutptr = &US2RxOutPtr;
-            break;
-
-        case USART3:
-            pbuf     = US3_rx_buf;
-            bufmax   = US3_RX_BUF_MAX;
-            rxinptr  = US3_RX_BUF_MAX - (AT91C_BASE_US3->US_RCR);
-            rxoutptr = &US3RxOutPtr;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_rx_buf;
-            bufmax   = USDBGU_RX_BUF_MAX;
-            rxinptr  = USDBGU_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);
-            rxoutptr = &USDBGURxOutPtr;
-            break;
-
-       default: return PARAMETER_ERR;
-    }
-
-    //RXInPtr = US0_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);//ȷǰջBUFĽָ
-    //ptrtemp = RXOutPtr; //BUFȡָ
-
-    // жûյһ֡
-    ptrtemp = *rxoutptr;
-    if(rxinptr >= bufmax)
-        rxinptr = 0;
-    while(1)
+    // жûյһ֡, ֡βڵ
+    recvcount = 0;
+    temp      = 0;
+    ptrtemp   = port->rx_outptr;
+    rxinptr   = Usart_RxInPtr(port);
+    do
     {
         if(ptrtemp == rxinptr)// ûյһ֡
             return RECV_ERR;
-        temp = pbuf[ptrtemp++];
+        last = temp;
+        temp = port->rx_buf[ptrtemp++];
         recvcount ++;
-        if(ptrtemp >= bufmax)
+        if(ptrtemp >= port->rx_size)
             ptrtemp = 0;
-        if(temp == frame_end_char1)//յһ֡β
-        {
-            if(ptrtemp == rxinptr)
-                return RECV_ERR;
-            temp = pbuf[ptrtemp++];
-            recvcount ++;
-            if(ptrtemp >= bufmax)
-                ptrtemp = 0;
-            if(temp == frame_end_char2)
-            {
-                break;
-            }
-            else 
-            {   //ָһλãӵڶλж
-                ptrtemp--;
-                recvcount--;
-            }
-        }
     }
+    while( (recvcount < 2) || (last != frame_end_char1) || (temp != frame_end_char2) );
 
     //յһ֡ȷ֡BUFǷ
     if(recvcount > frame_buf_size)
         return RECV_FRAME_BUF_FULL;
 
-    // һ֡COPY֡BUF
-    for(i = 0; i < recvcount; i ++)
-    {
-        *(pframe + i) = pbuf[(*rxoutptr)++];
-        if(*rxoutptr >= bufmax)
-            *rxoutptr = 0;
-    }
-    // BUFռ
-    for(i = recvcount; i < frame_buf_size; i ++)
-    {
-         *(pframe + i) = 0;
-    }
+    Usart_CopyOut(port, pframe, recvcount, frame_buf_size);
     *recv_bytes = recvcount;
+
     return RECV_OK;
 }
 
@@ -832,84 +578,22 @@ return: RECV_ERR
 */
 INT32U UsartGetFrame_by_Len(INT32U usart,INT32U frame_len, INT8U *pframe, INT32U frame_buf_size)
 {
-    INT32U i, ptrtemp;
-    INT32U bufmax, rxinptr;
-    INT8U  *pbuf;
-    INT32U *rxoutptr;
+    USART_PORT *port;
 
-    if( pframe == NULL )
+    port = Usart_GetPort(usart);
+    if( (pframe == NULL) || (port == NULL) )
         return PARAMETER_ERR;
 
     if(frame_len > frame_buf_size)
         return RECV_FRAME_BUF_FULL;
 
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_rx_buf;
-            bufmax   = US0_RX_BUF_MAX;
-            rxinptr  = US0_RX_BUF_MAX - (AT91C_BASE_US0->US_RCR);
-            rxoutptr = &US0RxOutPtr;
-            break;
-
-        case USART1:
-            pbuf     = US1_rx_buf;
-            bufmax   = US1_RX_BUF_MAX;
-            rxinptr  = US1_RX_BUF_MAX - (AT91C_BASE_US1->US_RCR);
-            rxoutptr = &US1RxOutPtr;
-            break;
-
-        case USART2:
-            pbuf     = US2_rx_buf;
-            bufmax   = US2_RX_BUF_MAX;
-            rxinptr  = US2_RX_BUF_MAX - (AT91C_BASE_US2->US_RCR);
-            rxoutptr = &US2RxOutPtr;
-            break;
-
-        case USART3:
-            pbuf     = US3_rx_buf;
-            bufmax   = US3_RX_BUF_MAX;
-            rxinptr  = US3_RX_BUF_MAX - (AT91C_BASE_US3->US_RCR);
-            rxoutptr = &US3RxOutPtr;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_rx_buf;
-            bufmax   = USDBGU_RX_BUF_MAX;
-            rxinptr  = USDBGU_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);
-            rxoutptr = &USDBGURxOutPtr;
-            break;
-
-       default: return PARAMETER_ERR;
-    }
-    //RXInPtr = US0_RX_BUF_MAX - (AT91C_BASE_DBGU->DBGU_RCR);//ȷǰջBUFĽָ
-    //ptrtemp = RXOutPtr; //BUFȡָ
-
     //жûյ֡
-    ptrtemp = *rxoutptr;
-    if(rxinptr >= bufmax)
-        rxinptr = 0;
-    for(i = 0; i < frame_len; i ++)
-    {
-        if(ptrtemp == rxinptr)
-            return RECV_ERR;
-        ptrtemp++;
-        if(ptrtemp >= bufmax)
-            ptrtemp = 0;
-    }
+    if(Usart_RxCount(port, Usart_RxInPtr(port)) < frame_len)
+        return RECV_ERR;
 
     //frame_lenֳ֡COPY frame buf 
-    for(i = 0; i < frame_len; i ++)
-    {
-        *(pframe + i ) = pbuf[(*rxoutptr)++];
-        if(*rxoutptr >= bufmax)
-            *rxoutptr = 0;
-    }
-    // BUFռ
-    for(i = frame_len; i < frame_buf_size; i ++)
-    {
-         *(pframe + i) = 0;
-    }
+    Usart_CopyOut(port, pframe, frame_len, frame_buf_size);
+
     return RECV_OK;
 }
 
@@ -931,56 +615,27 @@ return:     TRUE
 */
 BOOL UsartPutChar(INT32U usart, INT8U c)
 {
-    AT91S_USART *us;
-    if(usart == USDBGU)
-    {
-        // ȷTHR ѾûҪ͵
-        while( !((AT91C_BASE_DBGU->DBGU_CSR) & 0x02) );
-
-        //THR
-        AT91C_BASE_DBGU->DBGU_THR = c;
+    USART_PORT *port;
 
-        // ʹ
-        AT91C_BASE_DBGU->DBGU_CR = ((unsigned int) 0x1 <<  6) ;// TXEN
-
-        //ȴ
-        while( !((AT91C_BASE_DBGU->DBGU_CSR) & 0x02) );
-
-        return TRUE;
-    }
-
-    switch(usart)
-    {
-        case USART0:
-            us       = AT91C_BASE_US0;
-            break;
-
-        case USART1:
-            us       = AT91C_BASE_US1;
-            break;
-
-        case USART2:
-            us       = AT91C_BASE_US2;
-            break;
-
-        case USART3:
-            us       = AT91C_BASE_US3;
-            break;
-
-       default: return FALSE;
-    }
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return FALSE;
 
     // ȷTHR ѾûҪ͵
-    while( !((us->US_CSR) & 0x02) );
+    while( !((port->us->US_CSR) & AT91C_US_TXRDY) );
 
     //THR
-    us->US_THR = c;
+    port->us->US_THR = c;
 
     // ʹ
-    us->US_CR = ((unsigned int) 0x1 <<  6) ;// TXEN
+    port->us->US_CR = AT91C_US_TXEN;
 
     //ȴ
-    while( !((us->US_CSR) & 0x02) );
+    while( !((port->us->US_CSR) & AT91C_US_TXRDY) );
+
+    port->stat.tx_bytes++;
+
+    USART_CAP(usart, CAP_DIR_TX, &c, 1);
 
     return TRUE;
 }
@@ -1004,95 +659,24 @@ return: TRUE
 */
 BOOL UsartPutStr(INT32U usart, INT8U *pstr)
 {
-    INT32U      i = 0,  OverFlag = 0;
-    INT32U      bufmax;
-    INT8U       *pbuf;
-    AT91S_USART *us;
-    //ѡ񴮿
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_tx_buf;
-            bufmax   = US0_TX_BUF_MAX;
-            us       = AT91C_BASE_US0;
-            break;
-
-        case USART1:
-            pbuf     = US1_tx_buf;
-            bufmax   = US1_TX_BUF_MAX;
-            us       = AT91C_BASE_US1;
-            break;
-
-        case USART2:
-            pbuf     = US2_tx_buf;
-            bufmax   = US2_TX_BUF_MAX;
-            us       = AT91C_BASE_US2;
-            break;
-
-        case USART3:
-            pbuf     = US3_tx_buf;
-            bufmax   = US3_TX_BUF_MAX;
-            us       = AT91C_BASE_US3;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_tx_buf;
-            bufmax   = USDBGU_TX_BUF_MAX;
-            break;
-
-       default: return FALSE;
-    }
-    // ַ
-    do
-    {
-
-        while(*pstr) // ֵַCOPY TX_BUF
-        {
-            pbuf[i] = *pstr;
-            pstr++;
-            i++;
-            if(i >= bufmax) // TX_BUF ͷCOPY
-            {
-                i = 0;
-                break;
-            }
-        }
-        // ַCOPY ɻ߷BUFʼ
-
-         // ʼPDC
-        if(usart == USDBGU)
-        {
-            AT91C_BASE_DBGU->DBGU_TPR  = (INT32U) pbuf;
-            if(i == 0)
-                AT91C_BASE_DBGU->DBGU_TCR  = bufmax;
-            else
-                AT91C_BASE_DBGU->DBGU_TCR  = i;
+    INT32U i;
+    USART_PORT *port;
 
-            //ʹPDC tx
-            AT91C_BASE_DBGU->DBGU_PTCR = AT91C_PDC_TXTEN;
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return FALSE;
 
-            //ȴ
-            while( !((AT91C_BASE_DBGU->DBGU_CSR) & 0x10) );
-        }
-        else
+    // ַ, ÿһTX_BUF
+    while(*pstr)
+    {
+        i = 0;
+        while( (*pstr) && (i < port->tx_size) ) // ֵַCOPY TX_BUF
         {
-            us->US_TPR  = (INT32U) pbuf;
-            if(i == 0)
-                us->US_TCR  = bufmax;
-            else
-                us->US_TCR  = i;
-
-            //ʹPDC tx
-            us->US_PTCR = AT91C_PDC_TXTEN;
-
-            //ȴ
-            while( !((us->US_CSR) & 0x10) );
+            port->tx_buf[i++] = *pstr++;
         }
-
-        if(*pstr == 0x00)
-            OverFlag = 1;
+        // ַCOPY ɻ߷BUFʼ
+        Usart_PdcSend(port, i);
     }
-    while(OverFlag == 0);
 
     return TRUE;
 }
@@ -1115,94 +699,24 @@ return:    TRUE, 
 
 BOOL UsartPutFrame(INT32U usart, INT8U *pstr, INT32U length)
 {
-    INT32U 	    i ,OverFlag;
-    INT32U      bufmax;
-    INT8U       *pbuf, *pstr_start;
-    AT91S_USART *us;
+    INT32U i, n;
+    USART_PORT *port;
 
-    OverFlag = 0;
-    pstr_start = pstr;
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return FALSE;
 
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_tx_buf;
-            bufmax   = US0_TX_BUF_MAX;
-            us       = AT91C_BASE_US0;
-            break;
-
-        case USART1:
-            pbuf     = US1_tx_buf;
-            bufmax   = US1_TX_BUF_MAX;
-            us       = AT91C_BASE_US1;
-            break;
-
-        case USART2:
-            pbuf     = US2_tx_buf;
-            bufmax   = US2_TX_BUF_MAX;
-            us       = AT91C_BASE_US2;
-            break;
-
-        case USART3:
-            pbuf     = US3_tx_buf;
-            bufmax   = US3_TX_BUF_MAX;
-            us       = AT91C_BASE_US3;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_tx_buf;
-            bufmax   = USDBGU_TX_BUF_MAX;
-            break;
-
-       default: return FALSE;
-    }
-    // PDCʼ
-    do
+    // PDCʼ, ÿһTX_BUF
+    while(length)
     {
-        i = 0;
-        do
-        {
-            pbuf[i++] = *pstr++;
-            
-            if(pstr >= (pstr_start + length))
-              OverFlag = 1;
-        }
-        while((i < bufmax) && (OverFlag == 0));
-        // ַCOPY ɻ߷BUFʼ
-
-        // ʼPDC
-        if(usart == USDBGU)
-        {
-            AT91C_BASE_DBGU->DBGU_TPR  = (INT32U) pbuf;
-            //if(j == 0)
-               // AT91C_BASE_DBGU->DBGU_TCR  = bufmax;
-            //else
-                AT91C_BASE_DBGU->DBGU_TCR  = i;
-
-            //ʹPDC tx
-            AT91C_BASE_DBGU->DBGU_PTCR = AT91C_PDC_TXTEN;
-
-            //ȴ
-            while( !((AT91C_BASE_DBGU->DBGU_CSR) & 0x10) );
-        }
-        else
+        n = (length < port->tx_size) ? length : port->tx_size;
+        for(i = 0; i < n; i++)
         {
-            us->US_TPR  = (INT32U) pbuf;
-           // if(i == 0)
-             //   us->US_TCR  = bufmax;
-           // else
-                us->US_TCR  = i;
-
-            //ʹPDC tx
-            us->US_PTCR = AT91C_PDC_TXTEN;
-
-            //ȴ
-            while( !((us->US_CSR) & 0x10) );
+            port->tx_buf[i] = *pstr++;
         }
-       // if(i >= length)
-           // OverFlag = 1;
+        Usart_PdcSend(port, n);
+        length -= n;
     }
-    while(OverFlag == 0);
     return TRUE;
 }
 
@@ -1228,72 +742,32 @@ return:   TRUE
 BOOL UsartSendFrameStart(INT32U usart, INT8U *pstr, INT32U length)
 {
     INT32U i;
-    INT32U      bufmax;
-    INT8U       *pbuf;
-    AT91S_USART *us;
+    USART_PORT *port;
 
-    switch(usart)
-    {
-        case USART0:
-            pbuf     = US0_tx_buf;
-            bufmax   = US0_TX_BUF_MAX;
-            us       = AT91C_BASE_US0;
-            break;
-
-        case USART1:
-            pbuf     = US1_tx_buf;
-            bufmax   = US1_TX_BUF_MAX;
-            us       = AT91C_BASE_US1;
-            break;
-
-        case USART2:
-            pbuf     = US2_tx_buf;
-            bufmax   = US2_TX_BUF_MAX;
-            us       = AT91C_BASE_US2;
-            break;
-
-        case USART3:
-            pbuf     = US3_tx_buf;
-            bufmax   = US3_TX_BUF_MAX;
-            us       = AT91C_BASE_US3;
-            break;
-
-        case USDBGU:
-            pbuf     = USDBGU_tx_buf;
-            bufmax   = USDBGU_TX_BUF_MAX;
-            break;
-
-       default: return FALSE;
-    }
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return FALSE;
 
-    //жRX BUF ܷ
-    if(length > bufmax)
+    //жTX BUF ܷ
+    if(length > port->tx_size)
         return FALSE;
 
     //Ҫ͵COPYTX BUF
     for(i = 0; i < length; i++)
     {
-        pbuf[i] = *pstr++;
+        port->tx_buf[i] = *pstr++;
     }
 
-    if(usart == USDBGU)
-    {
-        // ʼPDC
-        AT91C_BASE_DBGU->DBGU_TPR  = (INT32U) pbuf;
-        AT91C_BASE_DBGU->DBGU_TCR  = length;
+    // ʼPDC
+    port->us->US_TPR  = (INT32U) port->tx_buf;
+    port->us->US_TCR  = length;
 
-        //ʹPDC tx
-        AT91C_BASE_DBGU->DBGU_PTCR = AT91C_PDC_TXTEN;
-    }
-    else
-    {
-        // ʼPDC
-        us->US_TPR  = (INT32U) pbuf;
-        us->US_TCR  = length;
+    //ʹPDC tx
+    port->us->US_PTCR = AT91C_PDC_TXTEN;
 
-        //ʹPDC tx
-        us->US_PTCR = AT91C_PDC_TXTEN;
-    }
+    port->stat.tx_bytes += length;
+
+    USART_CAP(usart, CAP_DIR_TX, port->tx_buf, length);
 
     return TRUE;
 }
@@ -1317,129 +791,152 @@ return: PDC_TX_DISABLE, // PDC 
 */
 INT32U UsartSendFrameCallback(INT32U usart, INT32U *unsendcount)
 {
-    AT91S_USART *us;
+    USART_PORT *port;
 
-    if(usart == USDBGU)
-    {
-        //жǷʹPDC
-        if( !((AT91C_BASE_DBGU->DBGU_PTSR) & 0x100) ) // TXEN δʹ
-            return PDC_TX_DISABLE;
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return PARAMETER_ERR;
 
-        if( (AT91C_BASE_DBGU->DBGU_CSR)& 0x10 )
-        {
-            *unsendcount = 0;
-            return PDC_TX_END;
-        }
-        else
-        {
-            *unsendcount = AT91C_BASE_DBGU->DBGU_TCR;
-            return PDC_TX_NO_END;
-        }
+    //жǷʹPDC
+    if( !((port->us->US_PTSR) & AT91C_PDC_TXTEN) ) // TXEN δʹ
+        return PDC_TX_DISABLE;
+
+    if( (port->us->US_CSR) & AT91C_US_ENDTX )
+    {
+        *unsendcount = 0;
+        return PDC_TX_END;
     }
     else
     {
-        switch(usart)
-        {
-            case USART0:
-                us       = AT91C_BASE_US0;
-                break;
+        *unsendcount = port->us->US_TCR;
+        return PDC_TX_NO_END;
+    }
+}
 
-            case USART1:
-                us       = AT91C_BASE_US1;
-                break;
+/*
+********************************************************************************
+                            UsartSendFrameQueue
 
-            case USART2:
-                us       = AT91C_BASE_US2;
-                break;
+function: ѵߵ֡BUFPDCͶ, COPY, ȴͽ
+          PDCʱ뵱ǰĴ(TPR/TCR), ڷʱһ֡Ĵ(TNPR/TNCR),
+          BUFʹü͡TNCRΪ0ʱ, ǰһBUFѾ, д
 
-            case USART3:
-                us       = AT91C_BASE_US3;
-                break;
+parameters: usart, ͨ,USART0,USART1,USART2,USART3,USDBGU
+            pframe, Ҫ͵֡BUF, ǰ޸
+            length, ͵ĳ
 
-            default: return PARAMETER_ERR;
-        }
+return:   TRUE ѷ
+          FALSE ôPDCĴʹ
+********************************************************************************
+*/
+BOOL UsartSendFrameQueue(INT32U usart, INT8U *pframe, INT32U length)
+{
+    USART_PORT *port;
 
-        //жǷʹPDC
-        if( !((us->US_PTSR) & 0x100) ) // TXEN δʹ
-            return PDC_TX_DISABLE;
+    port = Usart_GetPort(usart);
+    if( (port == NULL) || (pframe == NULL) || (length == 0) )
+        return FALSE;
 
-        if( (us->US_CSR)& 0x10 )
-        {
-            *unsendcount = 0;
-            return PDC_TX_END;
-        }
-        else
-        {
-            *unsendcount = us->US_TCR;
-            return PDC_TX_NO_END;
-        }
+    if( port->us->US_TCR == 0 )         // PDC 
+    {
+        port->us->US_TPR  = (INT32U) pframe;
+        port->us->US_TCR  = length;
+    }
+    else if( port->us->US_TNCR == 0 )   // ڷ, һ֡
+    {
+        port->us->US_TNPR = (INT32U) pframe;
+        port->us->US_TNCR = length;
+    }
+    else
+    {
+        return FALSE;
     }
+
+    //ʹPDC tx
+    port->us->US_PTCR = AT91C_PDC_TXTEN;
+
+    port->stat.tx_bytes += length;
+
+    USART_CAP(usart, CAP_DIR_TX, pframe, length);
+
+    return TRUE;
+}
+
+/*
+********************************************************************************
+                            UsartGetStat
+
+function: ȡڵշͳ, շֽ, BUFƴͽմ
+
+parameters: usart, ͨ,USART0,USART1,USART2,USART3,USDBGU
+            *stat, ͳݿָָĵַ
+
+return: TRUE
+        FALSE, ô
+
+********************************************************************************
+*/
+BOOL UsartGetStat(INT32U usart, USART_STAT *stat)
+{
+    USART_PORT *port;
+
+    port = Usart_GetPort(usart);
+    if( (port == NULL) || (stat == NULL) )
+        return FALSE;
+
+    *stat = port->stat;
+    return TRUE;
+}
+
+BOOL UsartClearStat(INT32U usart)
+{
+    USART_PORT *port;
+
+    port = Usart_GetPort(usart);
+    if(port == NULL)
+        return FALSE;
+
+    memset(&port->stat, 0, sizeof(USART_STAT));
+    return TRUE;
 }
 
 void US0_ISR_Handler() // US0 жϴ
 {
-    if ( (AT91C_BASE_US0->US_CSR) & 0x08) // ENDRX ж
-    {
-         // ʼPDC
-        AT91C_BASE_US0->US_RPR = (INT32U) US0_rx_buf;
-        AT91C_BASE_US0->US_RCR = US0_RX_BUF_MAX;
-    }
+    Usart_RxIsr(&UsartPortTab[USART0]);
 }
 
 
 void US1_ISR_Handler() // US1 жϴ
 {
-    if ( (AT91C_BASE_US1->US_CSR) & 0x08) // ENDRX ж
-    {
-         // ʼPDC
-        AT91C_BASE_US1->US_RPR = (INT32U) US1_rx_buf;
-        AT91C_BASE_US1->US_RCR = US1_RX_BUF_MAX;
-    }
+    Usart_RxIsr(&UsartPortTab[USART1]);
 }
 
 
 void US2_ISR_Handler() // US2 жϴ
 {
-    if ( (AT91C_BASE_US2->US_CSR) & 0x08) // ENDRX ж
-    {
-         // ʼPDC
-        AT91C_BASE_US2->US_RPR = (INT32U) US2_rx_buf;
-        AT91C_BASE_US2->US_RCR = US2_RX_BUF_MAX;
-    }
+    Usart_RxIsr(&UsartPortTab[USART2]);
 }
 
 
 void US3_ISR_Handler() // US3 жϴ
 {
-    if ( (AT91C_BASE_US3->US_CSR) & 0x08) // ENDRX ж
-    {
-         // ʼPDC
-        AT91C_BASE_US3->US_RPR = (INT32U) US3_rx_buf;
-        AT91C_BASE_US3->US_RCR = US3_RX_BUF_MAX;
-    }
+    Usart_RxIsr(&UsartPortTab[USART3]);
 }
 
 
 void USDBGU_ISR_Handler() // USDBGU жϴ
 {
-    if ( (AT91C_BASE_DBGU->DBGU_CSR) & 0x08) // ENDRX ж
-    {
-         // ʼPDC
-        AT91C_BASE_DBGU->DBGU_RPR = (INT32U) USDBGU_rx_buf;
-        AT91C_BASE_DBGU->DBGU_RCR = USDBGU_RX_BUF_MAX;
-    }
+    Usart_RxIsr(&UsartPortTab[USDBGU]);
 }
 
 INT32U UART_WriteStr( unsigned char * ptrChar )
 {
     int TxBufferCount = strlen((char const*)ptrChar);
-    
+
     while(TxBufferCount --)
     {
         UsartPutChar(USDBGU, *ptrChar ++);
     }
-    
+
     return 0;
 }
-
-
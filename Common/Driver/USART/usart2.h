@@ -67,6 +67,15 @@ typedef struct _USART_CONFIG {
     INT32U baudrate;
 } USART_CONFIG;
 
+// շͳ
+typedef struct _USART_STAT {
+    INT32U rx_bytes;    // ȡĽֽ
+    INT32U tx_bytes;    // ѷ͵ֽ
+    INT32U rx_wraps;    // ջBUFƴ
+    INT32U overrun;     // 
+    INT32U frame_err;   // ֡
+    INT32U parity_err;  // У
+} USART_STAT;
 
 //public functions
 
@@ -90,6 +99,9 @@ extern BOOL    UsartPutStr(INT32U usart, INT8U *pstr);
 extern BOOL    UsartPutFrame(INT32U usart, INT8U *pstr, INT32U length);
 extern BOOL    UsartSendFrameStart(INT32U usart, INT8U *pstr, INT32U length);
 extern INT32U  UsartSendFrameCallback(INT32U usart, INT32U *unsendcount);
+extern BOOL    UsartSendFrameQueue(INT32U usart, INT8U *pframe, INT32U length);
+extern BOOL    UsartGetStat(INT32U usart, USART_STAT *stat);
+extern BOOL    UsartClearStat(INT32U usart);
 
 extern INT32U UART_WriteStr( unsigned char * ptrChar );
 
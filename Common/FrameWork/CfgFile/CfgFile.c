@@ -3,6 +3,12 @@
 #define UPDATE_CFGFILE  //zjm
 //#define SELECTED_FILES  //zjm
 
+static ITEM_T CmdBatch[CMD_BATCH_MAX];     // consecutive "CMDB" lines waiting to be sent
+static U8 CmdBatchNum = 0;
+
+static ITEM_T ScanBatch[VSCAN_MAX];        // consecutive "VSCAN" lines waiting to be measured
+static U8 ScanBatchNum = 0;
+
 
 /******************************************************************************
     Routine Name    : Get_A_String
@@ -86,6 +92,102 @@ static BOOL ProcItem(P_ITEM_T pItem)
 	return(ret);
 }
 
+/******************************************************************************
+    Routine Name    : ProcBatch
+    Form            : static BOOL ProcBatch(void)
+    Parameters      : none
+    Return value    : TRUE/FALSE
+    Description     : Send the queued "CMDB" items as one batch, then show and log their results in order.
+******************************************************************************/
+static BOOL ProcBatch(void)
+{
+	U8 i;
+	BOOL ret = TRUE;
+
+    if(CmdBatchNum == 0)
+    {
+        return(TRUE);
+    }
+
+    Cmd_Batch(DUT_COMM_PORT, CmdBatch, CmdBatchNum);
+
+	for(i=0; i<CmdBatchNum; i++)
+	{
+	    LCD_DisplayAItem(CmdBatch[i].item);
+		LCD_DisplayResult(CmdBatch[i].retResult);
+
+        if(CmdBatch[i].retResult != PASS)
+        {
+            ret = FALSE;
+            break;
+        }
+	}
+    CmdBatchNum = 0;
+
+	return(ret);
+}
+
+/******************************************************************************
+    Routine Name    : ProcScan
+    Form            : static BOOL ProcScan(void)
+    Parameters      : none
+    Return value    : TRUE/FALSE
+    Description     : Measure the queued "VSCAN" items as one scan, then show their results in order.
+******************************************************************************/
+static BOOL ProcScan(void)
+{
+	U8 i;
+	BOOL ret = TRUE;
+
+    if(ScanBatchNum == 0)
+    {
+        return(TRUE);
+    }
+
+    TEST_VoltScan(ScanBatch, ScanBatchNum);
+
+	for(i=0; i<ScanBatchNum; i++)
+	{
+	    LCD_DisplayAItem(ScanBatch[i].item);
+		LCD_DisplayResult(ScanBatch[i].retResult);
+
+        if(ScanBatch[i].retResult != PASS)
+        {
+            ret = FALSE;
+            break;
+        }
+	}
+    ScanBatchNum = 0;
+
+	return(ret);
+}
+
+/******************************************************************************
+    Routine Name    : HasItem
+    Parameters      : list, id, e.g. ",INRUSH_T,"
+    Return value    : TRUE if a line that is not a comment has the id
+    Description     : Look for an item type before the list is run.
+******************************************************************************/
+static BOOL HasItem(U8 * list, char * id)
+{
+    char * p = (char * )list;
+    char * hit;
+    char * bol;
+
+    while((hit = strstr(p, id)) != NULL)
+    {
+        for(bol = hit; bol != (char * )list && *(bol - 1) != '\n'; bol--)  // the start of the line
+        {
+        }
+        if(*bol != '/')
+        {
+            return(TRUE);
+        }
+        p = hit + strlen(id);
+    }
+    return(FALSE);
+}
+
 /******************************************************************************
     Routine Name    : ProcLine
     Form            : static BOOL ProcLine(U8 * line)
@@ -154,6 +256,40 @@ static BOOL ProcLine(U8 * line)
     	pItem->Param = (U8)strtod((char * )str, NULL);	// Get the parameter.
 	}
 
+    if(strcmp((char * )pItem->id, "CMDB") == 0)    // Batch query, sent with the following "CMDB" lines.
+    {
+        if(ProcScan() == FALSE)
+        {
+            return(FALSE);
+        }
+        CmdBatch[CmdBatchNum++] = testItem;
+        if(CmdBatchNum < CMD_BATCH_MAX)
+        {
+            return(TRUE);
+        }
+    }
+    if(strcmp((char * )pItem->id, "VSCAN") == 0)   // Test point, measured with the following "VSCAN" lines.
+    {
+        if(ProcBatch() == FALSE)
+        {
+            return(FALSE);
+        }
+        ScanBatch[ScanBatchNum++] = testItem;
+        if(ScanBatchNum < VSCAN_MAX)
+        {
+            return(TRUE);
+        }
+    }
+
+    if(ProcBatch() == FALSE || ProcScan() == FALSE)
+    {
+        return(FALSE);
+    }
+    if(strcmp((char * )pItem->id, "CMDB") == 0 || strcmp((char * )pItem->id, "VSCAN") == 0)
+    {
+        return(TRUE);
+    }
+
     ret = ProcItem(pItem);
 	
 	return(ret);
@@ -173,6 +309,25 @@ char * Get_AB_Switch(void)
 }
 
 
+static U32 DutResult = FAIL;
+
+/******************************************************************************
+    Routine Name    : SaveDutData
+    Parameters      : none
+    Return value    : none
+    Description     : Save what the DUT has taught the fixture, run by the log
+                      task after the DUT log.
+******************************************************************************/
+static void SaveDutData(void)
+{
+    UsartCap_Save();    // keep the serial traffic of the last DUT when capturing
+    UsartCap_Stop();    // a capture covers the DUT whose list started it
+    CmdTmo_Save();      // learned DUT command timeouts
+    PWR_OfsSave();      // converged DUT supply positions
+    AD_HistSave();      // ranges of the ADC channels
+    RFREC_Save(DutResult);  // RF results of the DUT
+}
+
 /******************************************************************************
     Routine Name    : CFGFILE_Proc
     Form            : void CFGFILE_Proc(void)
@@ -212,6 +367,7 @@ void CFGFILE_Proc(void)
 	}
 	
     ptr = TestItemArray;
+    PWRMON_Arm(HasItem(TestItemArray, ",INRUSH_T,"));   // ϵʱĵֻҪб
 
 	while((line = (U8 * )strtok((char * )ptr, "\n")) != NULL)
 	{
@@ -227,10 +383,16 @@ void CFGFILE_Proc(void)
     	}
     }
 
+    if(line == NULL && (ProcBatch() == FALSE || ProcScan() == FALSE))  // The list ends with "CMDB" or "VSCAN" lines.
+    {
+        line = TestItemArray;
+    }
+
     PWR_TurnOffDut();
     
-    LOGFILE_Write();
-    
+    DutResult = (line == NULL) ? PASS : FAIL;
+    LOGFILE_Write(SaveDutData);     // the log task writes NAND, the result is shown at once
+
     if(line == NULL)    //testing pass.
     {
         HMI_ShowPass();
@@ -2,39 +2,94 @@
 
 #include "includes.h"
 
-#define CALIBRATE_RANGE_12V     12000
-#define CALIBRATE_RANGE_3V      3000
+/*
+    One guided session walks through CalPoint[], every point can be skipped.
+    A range with one point gets a gain in Init.csv, a range with more gets a
+    piecewise-linear table in AdCal.bin, see AD_Cal.c.
+*/
+#define CALIBRATE_TOL       (5)     // a point must read within 1/5 of its voltage
+
+typedef struct
+{
+    U32 range;
+    U32 ref;                        // mV
+
+} CAL_POINT;
+
+static const CAL_POINT CalPoint[] =
+{
+    {_RANGE_0_2V,     200},
+    {_RANGE_0_2V,    1000},
+    {_RANGE_0_2V,    1800},
+    {_RANGE_0_20V,   3000},
+    {_RANGE_0_20V,  12000},
+    {_RANGE_0_20V,  20000},
+    {_RANGE_0_200V, 24000},
+};
+
+/******************************************************************************
+    Routine Name    : Replace_InitLine
+    Parameters      : line, number of the line in InitArray
+                      str, the new line with its "\r\n"
+    Return value    : FALSE if the file has not so many lines or gets too long
+    Description     : Replace a whole line, the new one may be longer.
+******************************************************************************/
+static BOOL Replace_InitLine(U32 line, char * str)
+{
+    char * start = (char * )InitArray;
+    char * end;
+    U32 len, newLen, tail;
+
+    for(; line; line--)
+    {
+        if((start = strchr(start, '\n')) == NULL)
+        {
+            return(FALSE);
+        }
+        start++;
+    }
+    end = strchr(start, '\n');
+    end = end ? end + 1 : start + strlen(start);
+
+    len    = strlen((char * )InitArray);
+    newLen = strlen(str);
+    tail   = len - (U32)(end - (char * )InitArray);
+    if(len - (U32)(end - start) + newLen >= CH_INITFILE_MAX)
+    {
+        return(FALSE);
+    }
+
+    memmove(start + newLen, end, tail + 1);
+    memcpy(start, str, newLen);
+    return(TRUE);
+}
 
 static void Update_CalibrationValue(void)
 {
-    char title[] = "AD CALIBRATE S,AD CALIBRATE M,AD CALIBRATE L,\r\n";
-    char str[20];
-    U32 fraction_s, fraction_m, fraction_l;
-    char * p;
+    char title[] = "AD GAIN S ppm,AD GAIN M ppm,AD GAIN L ppm,AD OFS S uV,AD OFS M uV,AD OFS L uV\r\n";
+    char str[80];
+    INT32U gain[AD_RANGE_NUM];
+    S32 ofs[AD_RANGE_NUM];
+    U32 i;
     
 	FS_FILE *fb;
     
+    memset(InitArray, 0, CH_INITFILE_MAX);  // Clear the file.
 	if(fb = FS_FOpen(INIT_FILE,"r")) // Read the file.
 	{
-        memset(InitArray, 0, CH_INITFILE_MAX);  // Clear the file.
-		FS_FRead(InitArray,1,CH_INITFILE_MAX,fb);
+		FS_FRead(InitArray,1,CH_INITFILE_MAX - 1,fb);
 		FS_FClose(fb);
 	}
 	
-    p = strstr((char * )InitArray, title);
+    for(i = 0; i < AD_RANGE_NUM; i++)
+    {
+        AD_GetCal(_RANGE_0_2V + i, &gain[i], &ofs[i]);
+    }
+    sprintf(str, "%u,%u,%u,%d,%d,%d,\r\n", 
+            gain[0], gain[1], gain[2], ofs[0], ofs[1], ofs[2]);
 
-    if(p)
+    if(Replace_InitLine(INIT_AD_CAL_LINE - 1, title) && Replace_InitLine(INIT_AD_CAL_LINE, str))
     {
-        fraction_s = (U32)((verify_coef_range_s-(int)verify_coef_range_s)*10000000);
-        fraction_m = (U32)((verify_coef_range_m-(int)verify_coef_range_m)*10000000);
-        fraction_l = (U32)((verify_coef_range_l-(int)verify_coef_range_l)*10000000);
-        
-        sprintf(str, "%1d.%07d,%1d.%07d,%1d.%07d", 
-                (int)verify_coef_range_s, fraction_s, 
-                (int)verify_coef_range_m, fraction_m,
-                (int)verify_coef_range_l, fraction_l);
-        strncpy(p + strlen(title), str, strlen(str));
-        
     	if(fb = FS_FOpen(INIT_FILE,"w")) // Update the file.
     	{
     	    FS_FWrite(InitArray, 1, strlen((char * )InitArray), fb);
@@ -53,65 +108,54 @@ static void Display_Voltage(U32 volt)
 	LCD_DisplayALine(LCD_LINE2, str);
 }
 
-static U8 Calibrate_Proc(U32 volt_range)
+static BOOL Calibrate_WaitKey(void)
 {
-    U8 res = FALSE;
-	U32 volt;
+    BOOL yes;
 
-    if(volt_range == CALIBRATE_RANGE_12V)
-    {
-        volt = (U32)AD_MeasureAutoRange(volt_range);
-        Display_Voltage(volt);
-
-        if(volt > 9600 && volt < 14400)
-        {
-            verify_coef_range_l *= (float)(12000.0/volt);
-            res = TRUE;
-            
-            volt = (U32)AD_MeasureAutoRange(volt_range);
-            Display_Voltage(volt);
-            
-	        LCD_DisplayALine(LCD_LINE3, (U8 *)"Voltage Calibration OK!");
-	        OS_Delay(1000);
-        }
-        else
-        {
-	        LCD_DisplayALine(LCD_LINE3, (U8 *)"Voltage Value is ERR!");
-	        LCD_Clear(LCD_LINE4);
-	        OS_Delay(1000);
-        }
-    }
-    
-	if(volt_range == CALIBRATE_RANGE_3V)
+	while(1)
 	{
-        volt = (U32)AD_MeasureAutoRange(volt_range-1000);
-        Display_Voltage(volt);
+	    if(HMI_PressYesKey() == TRUE)
+	    {
+	        yes = TRUE;
+            break;
+	    }
+	    if(HMI_PressNoKey() == TRUE)
+	    {
+	        yes = FALSE;
+            break;
+	    }
+	}
+	while(HMI_PressYesKey() == TRUE || HMI_PressNoKey() == TRUE)
+	{}
+    return(yes);
+}
 
-        if(volt > 2400 && volt < 3600)
-        {
-            verify_coef_range_s *= (float)(3000.0/volt);
-            res |= TRUE;
-        
-            volt = (U32)AD_MeasureAutoRange(volt_range-1000);
-            Display_Voltage(volt);
-            
-	        LCD_DisplayALine(LCD_LINE3, (U8 *)"Voltage Calibration OK!");
-	        OS_Delay(1000);
-        }
-        else
-        {
-	        LCD_DisplayALine(LCD_LINE3, (U8 *)"Voltage Value is ERR!");
-	        LCD_Clear(LCD_LINE4);
-	        OS_Delay(1000);
-        }
+static U8 Calibrate_Proc(const CAL_POINT * ppt)
+{
+	U32 uv, volt;
+
+    uv = AD_ReadRawUv(ppt->range, PRECISION_16BIT);
+    volt = (uv + 500) / 1000;
+    Display_Voltage(volt);
+
+    if(volt > ppt->ref - ppt->ref / CALIBRATE_TOL && volt < ppt->ref + ppt->ref / CALIBRATE_TOL
+        && AD_CalAddPoint(ppt->range, uv, ppt->ref * 1000))
+    {
+        LCD_DisplayALine(LCD_LINE3, (U8 *)"Calibration Point OK!");
+        OS_Delay(1000);
+        return(TRUE);
     }
-    
-    return(res);
+
+    LCD_DisplayALine(LCD_LINE3, (U8 *)"Voltage Value is ERR!");
+    LCD_Clear(LCD_LINE4);
+    OS_Delay(1000);
+    return(FALSE);
 }
 
 void Volt_Calibration(void)
 {
-    U8 res = FALSE;
+    U32 i;
+    U8 str[30];
     
 	if(HMI_PressYesKey() == FALSE)
 	{
@@ -133,45 +177,25 @@ void Volt_Calibration(void)
 	while(HMI_PressNoKey() == TRUE)
 	{}
 	
-	HMI_PassBuzz();
-	LCD_DisplayALine(LCD_LINE1, (U8 *)"Voltage Calibration 12V");
-	LCD_DisplayALine(LCD_LINE2, (U8 *)"Please connect DC 12V");
-	LCD_DisplayALine(LCD_LINE3, (U8 *)"Press Yes key to start");
-	LCD_DisplayALine(LCD_LINE4, (U8 *)"Press No key to exit");
-	
-	while(1)
-	{
-	    if(HMI_PressYesKey() == TRUE)
-	    {
-	        res = Calibrate_Proc(CALIBRATE_RANGE_12V);
-            break;
-	    }
-	    if(HMI_PressNoKey() == TRUE)
-	    {
-            break;
-	    }
-	}
-	
-	HMI_PassBuzz();
-	LCD_DisplayALine(LCD_LINE1, (U8 *)"Voltage Calibration 3V");
-	LCD_DisplayALine(LCD_LINE2, (U8 *)"Please connect DC 3V");
-	LCD_DisplayALine(LCD_LINE3, (U8 *)"Press Yes key to start");
-	LCD_DisplayALine(LCD_LINE4, (U8 *)"Press No key to exit");
-	
-	while(1)
-	{
-	    if(HMI_PressYesKey() == TRUE)
-	    {
-	        res |= Calibrate_Proc(CALIBRATE_RANGE_3V);
-            break;
-	    }
-	    if(HMI_PressNoKey() == TRUE)
-	    {
-            break;
-	    }
-	}
+    AD_CalBegin();
+    for(i = 0; i < sizeof(CalPoint) / sizeof(CalPoint[0]); i++)
+    {
+    	HMI_PassBuzz();
+        sprintf((char *)str, "Calibration %d/%d %d.%03dV", i + 1, sizeof(CalPoint) / sizeof(CalPoint[0]),
+                CalPoint[i].ref / 1000, CalPoint[i].ref % 1000);
+    	LCD_DisplayALine(LCD_LINE1, str);
+        sprintf((char *)str, "Please connect DC %d.%03dV", CalPoint[i].ref / 1000, CalPoint[i].ref % 1000);
+    	LCD_DisplayALine(LCD_LINE2, str);
+    	LCD_DisplayALine(LCD_LINE3, (U8 *)"Press Yes key to start");
+    	LCD_DisplayALine(LCD_LINE4, (U8 *)"Press No key to skip");
+
+        if(Calibrate_WaitKey() == TRUE)
+        {
+            Calibrate_Proc(&CalPoint[i]);
+        }
+    }
 	
-	if(res == FALSE)
+	if(AD_CalCommit() == FALSE)
 	{
 	    LCD_DisplayALine(LCD_LINE3, (U8 *)"Voltage Calibration fail");
     }
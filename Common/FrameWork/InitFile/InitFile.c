@@ -28,8 +28,8 @@ U8 InitArray[CH_INITFILE_MAX] =
 "AUX_USART2,2400,1,US_EVEN\r\n"    //ͨRS485
 //"AUX_USART2,115200,1,NONE\r\n"    //
 "MERAK_USART0,115200,1,NONE\r\n"  //MERAK ͨRS485
-"AD CALIBRATE S,AD CALIBRATE M,CALIBRATE L,\r\n"
-"1.0000000,1.0000000,1.0000000,\r\n"
+"AD GAIN S ppm,AD GAIN M ppm,AD GAIN L ppm,AD OFS S uV,AD OFS M uV,AD OFS L uV\r\n"
+"1000000,1000000,1000000,0,0,0,\r\n"
 //"RLY_SUM,RLY_ADMODE,RLY_CMMODE,\r\n"
 //"2,1,2,\r\n"
 "MAC ADDRESS,IP ADDRESS,SUBNET MASK,GATEWAY ADDR\r\n"
@@ -40,10 +40,6 @@ USART_CONFIG MerakCOMM_setting = {MERAK_COMM_PORT, US_RS485, CHRL_8, US_NONE, ST
 USART_CONFIG DutCOMM_setting   = {DUT_COMM_PORT,   US_RS232, CHRL_8, US_NONE, STOP_1, 115200}; //DUT
 USART_CONFIG AuxCOMM_setting   = {AUX_COMM_PORT,   US_RS232, CHRL_8, US_EVEN, STOP_1, 2400}; //ͨڲ
 
-float  verify_coef_range_s = 1.0000000;// ޷ѹϵ
-float  verify_coef_range_m = 1.0000000;// 10:1 ѹϵ
-float  verify_coef_range_l = 1.0000000;// 100:1 ѹϵ
-
 typedef void (*SETTING_FUNC)(U8 * initStr);
 
 static BOOL GetString(U8 * line, U8 * str)
@@ -151,42 +147,71 @@ static void MerakComSetting(U8 * initStr)
     CommSetting((USART_CONFIG * )&MerakCOMM_setting.usartport, initStr);
 }
 
-static void GetAdParam(U8 * initStr, float * cal_s, float * cal_m, float * cal_l)
+/******************************************************************************
+    Routine Name    : GetAdGain
+    Parameters      : str
+    Return value    : gain in ppm, 0 if empty
+    Description     : "1000234" is ppm, an old file has the ratio "1.0002340".
+                      Both are read without floating point.
+******************************************************************************/
+static U32 GetAdGain(U8 * str)
 {
-    U8 pos;
-	U8 str[CH_INITSTR_MAX];
-	
-	if((pos = GetString(initStr, str)) < CH_PERSTR_MAX)	    //Get a string. 
-	{
-		* cal_s = strtof((char * )str, NULL);   // get the cal data from each string.
-	}
-	if((GetString(initStr+pos, str)) < CH_PERSTR_MAX)	    //Get a string. 
-	{
-		* cal_m = strtof((char * )str, NULL);   // get the cal data from each string.
-	}
-	if((GetString(initStr+pos, str)) < CH_PERSTR_MAX)	    //Get a string. 
-	{
-		* cal_l = strtof((char * )str, NULL);   // get the cal data from each string.
-	}
+    char * p;
+    U32 gain, scale;
+
+    gain = (U32)strtoul((char * )str, &p, 10);
+    if(*p != '.')
+    {
+        return(gain);
+    }
+
+    gain *= AD_GAIN_UNITY;
+    for(scale = AD_GAIN_UNITY / 10, p++; scale && *p >= '0' && *p <= '9'; scale /= 10, p++)
+    {
+        gain += (*p - '0') * scale;
+    }
+    if(scale == 0 && *p >= '5' && *p <= '9')    // round the 7th digit
+    {
+        gain++;
+    }
+    return(gain);
 }
 
 static void ADCalSetting(U8 * initStr)
 {
-    float cal_s, cal_m, cal_l;
-    
-    GetAdParam(initStr, (float * )&cal_s, (float * )&cal_m, (float * )&cal_l);
-    
-    if(cal_s)
-    {
-        verify_coef_range_s = cal_s;
-    }
-    if(cal_m)
+    U8 pos;
+	U8 str[CH_INITSTR_MAX];
+    U32 gain[AD_RANGE_NUM];
+    S32 ofs[AD_RANGE_NUM];
+    U32 i;
+
+    memset(gain, 0, sizeof(gain));
+    memset(ofs, 0, sizeof(ofs));
+
+    // "gain S,gain M,gain L,offset S,offset M,offset L,", an old file has no offsets
+    for(i = 0; i < AD_RANGE_NUM * 2 && *initStr && *initStr != '\r'; i++)
     {
-        verify_coef_range_m = cal_m;
+    	if((pos = GetString(initStr, str)) >= CH_PERSTR_MAX)	    //Get a string. 
+    	{
+    	    break;
+    	}
+        if(i < AD_RANGE_NUM)
+        {
+            gain[i] = GetAdGain(str);
+        }
+        else
+        {
+            ofs[i - AD_RANGE_NUM] = (S32)strtol((char * )str, NULL, 10);
+        }
+		initStr += pos;
     }
-    if(cal_l)
+
+    for(i = 0; i < AD_RANGE_NUM; i++)
     {
-        verify_coef_range_l = cal_l;
+        if(gain[i])
+        {
+            AD_SetCal(_RANGE_0_2V + i, gain[i], ofs[i]);
+        }
     }
 }
 
@@ -263,7 +288,14 @@ static void FIX_Init(void)
     UART_Init();
 	MERAK_ResetALL();
     //i2c_init();
-	i2c_ADC_init(verify_coef_range_s, verify_coef_range_m, verify_coef_range_l);
+	AD_CalInit();
+	i2c_ADC_init();
+	AD_HistInit();
+	CmdTmo_Init();
+	PWR_OfsInit();
+	PWRMON_Init();
+	RFREC_Init();
+	LOGFILE_Init();
     //IP_Ping_Init();
     HMI_OnRunLed();
     RLY_SetCommonMode(1);
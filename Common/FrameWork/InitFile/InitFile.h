@@ -16,12 +16,10 @@
 #define CH_INITFILE_MAX	(500)
 
 #define INIT_FILE	"Init.csv"
+#define INIT_AD_CAL_LINE    (5)     // line of the AD calibration values, see SettingFunc[]
 
 extern U8 InitArray[CH_INITFILE_MAX];
 
-extern float  verify_coef_range_s;  // ޷ѹϵ
-extern float  verify_coef_range_m;  // 10:1 ѹϵ
-extern float  verify_coef_range_l;  // 100:1 ѹϵ
 
 extern void INITFILE_Proc(void);
 
@@ -2,44 +2,233 @@
 #include "includes.h"
 
 #define LOG_LEN_1_PCS           (15000)
-#define LOG_FILE_CUT_MAX        (400000)
-#define LOG_FILE_TOTAL_MAX      (1000000)
+#define LOG_SEG_SIZE            (100000)        // a segment is closed once it reaches this size
+#define LOG_SEG_MAX             (10)            // segments kept, the oldest is deleted
+#define LOG_IDX_MAGIC           (0x31474F4C)    // "LOG1"
+#define LOG_QUEUE_MAX           (2)             // DUT logs: the one being filled and one waiting
+#define LOG_TASK_PRIO           (120)           // below the test task
+#define LOG_FLUSH_MS            (5000)
 
-#define LOG_FILE	"TestLog.txt"
+#define LOG_IDX_FILE    "TestLog.idx"
+#define LOG_SEG_FILE    "TLog%04d.txt"          // segment number % 10000, oldest first
+#define LOG_OLD_FILE    "TestLog.txt"           // the single log file of the old versions
 
-static U8 logStr[LOG_LEN_1_PCS] = {0};
+typedef struct
+{
+    U32 magic;
+    U32 first;      // oldest segment kept
+    U32 last;       // segment being appended
 
-void LOGFILE_AddItem(U8 * str)
+} LOG_IDX;
+
+/*
+    LOGFILE_Write only queues the log of the DUT, the log task appends it to
+    NAND in the background and then runs the job queued with it (the other
+    end of DUT saves), so the result is shown without waiting for the file
+    system. The queue is bounded: when LOG_QUEUE_MAX logs are queued the
+    next LOGFILE_Write waits for the task. LOGFILE_Flush is called before
+    the fixture resets.
+*/
+static U8 logStr[LOG_QUEUE_MAX][LOG_LEN_1_PCS] = {0};
+static LOG_JOB logJob[LOG_QUEUE_MAX];
+static U32 logHead = 0;         // logs queued, logStr[logHead % LOG_QUEUE_MAX] is being filled
+static U32 logTail = 0;         // logs written
+static LOG_IDX logIdx;
+
+static OS_STACKPTR int Stack_Log[512];
+static OS_TASK TCB_Log;
+static OS_CSEMA LogReady_Sem;   // logs waiting for the task
+static OS_CSEMA LogFree_Sem;    // free slots
+static BOOL logTaskOn = FALSE;
+
+static void LOGFILE_SegName(char * name, U32 seg)
 {
-	strcat((char * )logStr, (char * )str);
+    sprintf(name, LOG_SEG_FILE, seg % 10000);
 }
 
-void LOGFILE_Write(void)
+static void LOGFILE_SaveIdx(void)
 {
-	I32 pos;
 	FS_FILE *fb;
 
-    static char fileStr[LOG_FILE_TOTAL_MAX];
+	if(fb = FS_FOpen(LOG_IDX_FILE,"wb"))
+	{
+	    FS_FWrite(&logIdx, sizeof(logIdx), 1, fb);
+	    FS_SetEndOfFile(fb);
+        FS_FClose(fb);
+    }
+}
+
+/*
+    Close the current segment and start the next one. Only the index is
+    written and at most one old segment removed, so the cost does not
+    depend on how much has been logged.
+*/
+static void LOGFILE_NextSeg(void)
+{
+    char name[16];
+
+    logIdx.last++;
+    while(logIdx.last - logIdx.first >= LOG_SEG_MAX)
+    {
+        LOGFILE_SegName(name, logIdx.first);
+        FS_Remove(name);
+        logIdx.first++;
+    }
+    LOGFILE_SaveIdx();
+}
+
+static void LOGFILE_Append(U8 * str)
+{
+	FS_FILE *fb;
+	char name[16];
+	U32 size = 0;
 
-	if(fb = FS_FOpen(LOG_FILE,"a+"))
+    LOGFILE_SegName(name, logIdx.last);
+	if(fb = FS_FOpen(name,"a"))
 	{
-	    FS_FWrite(logStr, 1, strlen((char * )logStr), fb);
-
-        FS_FSeek(fb, 0, FS_SEEK_END);
-	    pos = FS_FTell(fb);
-	    if(pos > LOG_FILE_TOTAL_MAX-LOG_LEN_1_PCS)
-	    {
-            FS_FSeek(fb, 0, FS_SEEK_SET);
-            FS_FRead(fileStr,1,pos,fb);
-            FS_FSeek(fb, 0, FS_SEEK_SET);
-            FS_FWrite(fileStr+LOG_FILE_CUT_MAX, pos-LOG_FILE_CUT_MAX, 1, fb);
-            FS_SetEndOfFile(fb);
-	    }
+	    FS_FWrite(str, 1, strlen((char * )str), fb);
+	    size = FS_GetFileSize(fb);
         FS_FClose(fb);
     }
-	
-    memset((char * )logStr, 0, sizeof(logStr));
+
+    if(size >= LOG_SEG_SIZE)
+    {
+        LOGFILE_NextSeg();
+    }
 }
 
+static void Log_Task(void)
+{
+    U8 * str;
+
+    while(1)
+    {
+        OS_WaitCSema(&LogReady_Sem);
 
+        str = logStr[logTail % LOG_QUEUE_MAX];
+        LOGFILE_Append(str);
+        memset((char * )str, 0, LOG_LEN_1_PCS);
+        if(logJob[logTail % LOG_QUEUE_MAX])
+        {
+            logJob[logTail % LOG_QUEUE_MAX]();
+        }
+        logTail++;
 
+        OS_SignalCSema(&LogFree_Sem);
+    }
+}
+
+/*
+    The old TestLog.txt becomes segment 0 when the segments are started, so
+    it is rotated out like any other segment. If segments already exist it
+    is older than all of them and is deleted.
+*/
+static void LOGFILE_Migrate(BOOL fresh)
+{
+	FS_FILE *fb;
+    char name[16];
+
+	if((fb = FS_FOpen(LOG_OLD_FILE,"rb")) == NULL)
+	{
+	    return;
+	}
+    FS_FClose(fb);
+
+    LOGFILE_SegName(name, logIdx.last);
+    if(fresh && FS_Rename(LOG_OLD_FILE, name) == 0)
+    {
+        LOGFILE_NextSeg();
+    }
+    else
+    {
+        FS_Remove(LOG_OLD_FILE);
+    }
+}
+
+void LOGFILE_Init(void)
+{
+	FS_FILE *fb;
+	BOOL fresh = FALSE;
+
+    memset(&logIdx, 0, sizeof(logIdx));
+	if(fb = FS_FOpen(LOG_IDX_FILE,"rb"))
+	{
+	    FS_FRead(&logIdx, sizeof(logIdx), 1, fb);
+        FS_FClose(fb);
+    }
+
+    if(logIdx.magic != LOG_IDX_MAGIC || logIdx.last < logIdx.first)
+    {
+        logIdx.magic = LOG_IDX_MAGIC;
+        logIdx.first = 0;
+        logIdx.last  = 0;
+        LOGFILE_SaveIdx();
+        fresh = TRUE;
+    }
+    LOGFILE_Migrate(fresh);
+
+    OS_CREATECSEMA(&LogReady_Sem);
+    OS_CreateCSema(&LogFree_Sem, LOG_QUEUE_MAX - 1);
+    OS_CREATETASK(&TCB_Log, "Log Task", Log_Task, LOG_TASK_PRIO, Stack_Log);
+    logTaskOn = TRUE;
+}
+
+void LOGFILE_AddItem(U8 * str)
+{
+	strcat((char * )logStr[logHead % LOG_QUEUE_MAX], (char * )str);
+}
+
+/******************************************************************************
+    Routine Name    : LOGFILE_Write
+    Parameters      : job, run by the log task after the log is written,
+                      NULL for none
+    Return value    : none
+    Description     : Queue the log of the DUT and start a new one. Written
+                      at once if the log task is not running.
+******************************************************************************/
+void LOGFILE_Write(LOG_JOB job)
+{
+    if(logTaskOn == FALSE)
+    {
+        LOGFILE_Append(logStr[logHead % LOG_QUEUE_MAX]);
+        memset((char * )logStr[logHead % LOG_QUEUE_MAX], 0, LOG_LEN_1_PCS);
+        if(job)
+        {
+            job();
+        }
+        return;
+    }
+
+    logJob[logHead % LOG_QUEUE_MAX] = job;
+    logHead++;
+    OS_SignalCSema(&LogReady_Sem);
+    OS_WaitCSema(&LogFree_Sem);     // the next slot, waits while the queue is full
+}
+
+/******************************************************************************
+    Routine Name    : LOGFILE_Flush
+    Parameters      : none
+    Return value    : TRUE if every queued log and job is done
+    Description     : Wait for the log task, called before a reset. Gives up
+                      after LOG_FLUSH_MS so a broken NAND cannot keep the
+                      fixture from resetting.
+******************************************************************************/
+BOOL LOGFILE_Flush(void)
+{
+    U32 t0 = OS_GetTime32();
+
+    if(logTaskOn == FALSE)
+    {
+        return(TRUE);
+    }
+
+    while(logTail != logHead)
+    {
+        if(OS_GetTime32() - t0 > LOG_FLUSH_MS)
+        {
+            return(FALSE);
+        }
+        OS_Delay(10);
+    }
+    return(TRUE);
+}
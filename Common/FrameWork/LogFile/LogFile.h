@@ -3,7 +3,11 @@
 #ifndef _LOG_FILE_H_
 #define _LOG_FILE_H_
 
-extern void LOGFILE_Write(void);
+extern void LOGFILE_Init(void);
+typedef void (*LOG_JOB)(void);
+
+extern void LOGFILE_Write(LOG_JOB job);
+extern BOOL LOGFILE_Flush(void);
 extern void LOGFILE_AddItem(U8 * str);
 
 
@@ -0,0 +1,164 @@
+/*******************************************************************************
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+    File name:  RfRec.c
+    Function: Per-DUT RF result record
+    IDE:    IAR EWARM V6.4
+    ICE:    J-Link
+    BOARD:  Merak Main board
+    History
+                ver.1.00    First release
+
+    The RF items fill one RF_REC while a DUT is tested: the RSSI statistics
+    and histogram of the carrier test, the RFDA_T packet count and the
+    RFPER_T packet error rate. After the DUT the record is written to a
+    fixed slot of RfRec.bin (RF_REC_HEAD, then RF_REC_MAX records used as a
+    ring), so the station statistics can be read on the host straight from
+    the file instead of parsing the text log. A DUT that ran no RF item
+    writes nothing.
+*******************************************************************************/
+#include "includes.h"
+
+#define RF_REC_MAGIC        (0x31434652)    // "RFC1"
+
+extern U8 barCode_List[5][20];
+extern U8 barCode_Slot;
+
+static RF_REC RfRec;
+static U32 RfRecCount = 0;
+
+/******************************************************************************
+    Routine Name    : RFREC_Init
+    Parameters      : none
+    Return value    : none
+    Description     : Read the record count of the store, a missing or
+                      foreign file is started again.
+******************************************************************************/
+void RFREC_Init(void)
+{
+    FS_FILE *fb;
+    RF_REC_HEAD head;
+
+    RfRecCount = 0;
+    memset(&head, 0, sizeof(head));
+    if(fb = FS_FOpen(RF_REC_FILE,"rb"))
+    {
+        FS_FRead(&head, sizeof(head), 1, fb);
+        FS_FClose(fb);
+    }
+
+    if(head.magic == RF_REC_MAGIC && head.recSize == sizeof(RF_REC))
+    {
+        RfRecCount = head.count;
+    }
+    else
+    {
+        FS_Remove(RF_REC_FILE);
+    }
+    RFREC_Begin();
+}
+
+/******************************************************************************
+    Routine Name    : RFREC_Begin
+    Parameters      : none
+    Return value    : none
+    Description     : Clear the record for a new DUT.
+******************************************************************************/
+void RFREC_Begin(void)
+{
+    memset(&RfRec, 0, sizeof(RfRec));
+    Stat_HistInit(&RfRec.cwHist, RF_REC_RSSI_LOW, RF_REC_RSSI_HIGH);
+}
+
+void RFREC_CwAdd(S32 x)
+{
+    Stat_HistAdd(&RfRec.cwHist, x);
+}
+
+void RFREC_Cw(U8 chn, P_STAT_ACC acc, S32 lower, S32 upper, U32 result)
+{
+    RfRec.flags   |= RF_REC_CW;
+    RfRec.chn      = chn;
+    RfRec.cwResult = (U8)result;
+    RfRec.cwN      = acc->n;
+    RfRec.cwMean   = Stat_Mean(acc);
+    RfRec.cwVar    = Stat_Var(acc);
+    RfRec.cwMin    = acc->min;
+    RfRec.cwMax    = acc->max;
+    RfRec.cwCpk100 = Stat_Cpk100(acc, lower, upper);
+}
+
+void RFREC_Data(U8 chn, U32 sent, U32 lost, U32 result)
+{
+    RfRec.flags     |= RF_REC_DATA;
+    RfRec.chn        = chn;
+    RfRec.dataResult = (U8)result;
+    RfRec.dataSent   = sent;
+    RfRec.dataLost   = lost;
+}
+
+void RFREC_Per(U8 chn, U32 sent, U32 lost, U32 per, U32 lo, U32 hi, P_STAT_ACC rssi, U32 result)
+{
+    RfRec.flags    |= RF_REC_PER;
+    RfRec.chn       = chn;
+    RfRec.perResult = (U8)result;
+    RfRec.perSent   = sent;
+    RfRec.perLost   = lost;
+    RfRec.per       = per;
+    RfRec.perLo     = lo;
+    RfRec.perHi     = hi;
+    RfRec.perRssi   = rssi->n ? Stat_Mean(rssi) : 0;
+}
+
+/******************************************************************************
+    Routine Name    : RFREC_Save
+    Parameters      : result, PASS/FAIL of the DUT
+    Return value    : none
+    Description     : Write the record of the DUT to its slot and update
+                      the count in the head, then clear it for the next one.
+******************************************************************************/
+void RFREC_Save(U32 result)
+{
+    FS_FILE *fb;
+    RF_REC_HEAD head;
+
+    if(RfRec.flags == 0)
+    {
+        return;
+    }
+
+    head.magic   = RF_REC_MAGIC;
+    head.recSize = sizeof(RF_REC);
+    if((fb = FS_FOpen(RF_REC_FILE,"r+b")) == NULL)
+    {
+        if(fb = FS_FOpen(RF_REC_FILE,"w+b"))    // the records are appended, never seek past the end
+        {
+            RfRecCount = 0;
+            head.count = 0;
+            FS_FWrite(&head, sizeof(head), 1, fb);
+        }
+    }
+    if(fb)
+    {
+        RfRec.seq    = RfRecCount + 1;
+        RfRec.time   = OS_GetTime32();
+        RfRec.result = (U8)result;
+        if(barCode_Slot < 5)   // the slot the BAR_* items used, not the RF port
+        {
+            memcpy(RfRec.sn, barCode_List[barCode_Slot], RF_REC_SN_LEN);
+        }
+
+        FS_FSeek(fb, sizeof(RF_REC_HEAD) + (RfRecCount % RF_REC_MAX) * sizeof(RF_REC), FS_SEEK_SET);
+        if(FS_FWrite(&RfRec, sizeof(RF_REC), 1, fb) == 1)
+        {
+            RfRecCount++;
+            head.count = RfRecCount;
+            FS_FSeek(fb, 0, FS_SEEK_SET);
+            FS_FWrite(&head, sizeof(head), 1, fb);
+        }
+        FS_FClose(fb);
+    }
+
+    RFREC_Begin();
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+    Copyright(C) 2014, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+    File name:  RfRec.h
+    Function: Per-DUT RF result record head file
+    IDE:    IAR EWARM V6.4
+    ICE:    J-Link
+    BOARD:  Merak Main board
+    History
+                ver.1.00    First release
+*******************************************************************************/
+#ifndef _RFREC_H_
+#define _RFREC_H_
+
+#define RF_REC_FILE         "RfRec.bin"
+#define RF_REC_MAX          (2048)          // records kept, the oldest is overwritten
+#define RF_REC_SN_LEN       (20)
+
+#define RF_REC_RSSI_LOW     (30000)         // histogram range, -dBm x1000
+#define RF_REC_RSSI_HIGH    (110000)        // 2.5dB per bin
+
+// RF_REC.flags, the tests the DUT ran
+#define RF_REC_CW           (0x01)          // RSSI while the DUT sends the carrier
+#define RF_REC_DATA         (0x02)          // RFDA_T packets
+#define RF_REC_PER          (0x04)          // RFPER_T packets
+
+typedef struct
+{
+    U32 magic;
+    U32 recSize;                    // sizeof(RF_REC), the host checks it
+    U32 count;                      // records ever written, slot is count % RF_REC_MAX
+
+} RF_REC_HEAD;
+
+typedef struct
+{
+    U32 seq;                        // count of the store when written, from 1
+    U32 time;                       // OS_GetTime32(), ms
+    U8  sn[RF_REC_SN_LEN];          // bar code, not terminated when full
+    U8  result;                     // PASS/FAIL of the whole DUT
+    U8  flags;
+    U8  chn;                        // RF port of the items
+    U8  reserved;
+
+    U8  cwResult;                   // PASS/FAIL of each test
+    U8  dataResult;
+    U8  perResult;
+    U8  reserved2;
+
+    U32 cwN;                        // RSSI samples, -dBm x1000
+    S32 cwMean;
+    U32 cwVar;
+    S32 cwMin;
+    S32 cwMax;
+    S32 cwCpk100;
+    STAT_HIST cwHist;
+
+    U32 dataSent;
+    U32 dataLost;
+
+    U32 perSent;
+    U32 perLost;
+    U32 per;                        // % x1000
+    U32 perLo;                      // 95% interval
+    U32 perHi;
+    S32 perRssi;                    // mean RSSI of the packets, 0 if not reported
+
+} RF_REC, * P_RF_REC;
+
+extern void RFREC_Init(void);
+extern void RFREC_Begin(void);
+extern void RFREC_CwAdd(S32 x);
+extern void RFREC_Cw(U8 chn, P_STAT_ACC acc, S32 lower, S32 upper, U32 result);
+extern void RFREC_Data(U8 chn, U32 sent, U32 lost, U32 result);
+extern void RFREC_Per(U8 chn, U32 sent, U32 lost, U32 per, U32 lo, U32 hi, P_STAT_ACC rssi, U32 result);
+extern void RFREC_Save(U32 result);
+
+#endif
@@ -0,0 +1,478 @@
+/*******************************************************************************
+    Stats.c
+    Fixed-point measurement statistics
+
+    Copyright(C) 2010, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+
+    Single-pass (Welford) mean and variance of integer samples, no floating
+    point and no sample buffer. The mean and M2 are kept in 64-bit Q8 so a
+    stream of milli-unit samples does not lose the fraction of the mean.
+
+    All measurement items judge their value with Stat_Limit(): a value
+    passes when lower <= value <= upper, both limits included, in the unit
+    of ITEM_T lower/upper (x1000 of the test list value).
+*******************************************************************************/
+#include "includes.h"
+
+#define STAT_ONE        ((S64)1 << STAT_Q)
+
+/******************************************************************************
+    Routine Name    : Stat_Reset
+    Parameters      : acc
+    Return value    : none
+    Description     : Clear an accumulator.
+******************************************************************************/
+void Stat_Reset(P_STAT_ACC acc)
+{
+    memset(acc, 0, sizeof(STAT_ACC));
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Add
+    Parameters      : acc, x
+    Return value    : none
+    Description     : Add one sample.
+******************************************************************************/
+void Stat_Add(P_STAT_ACC acc, S32 x)
+{
+    S64 xq = (S64)x << STAT_Q;
+    S64 delta;
+
+    acc->n++;
+    if(acc->n == 1)
+    {
+        acc->min  = x;
+        acc->max  = x;
+        acc->mean = xq;
+        acc->m2   = 0;
+        return;
+    }
+
+    if(x < acc->min)
+    {
+        acc->min = x;
+    }
+    if(x > acc->max)
+    {
+        acc->max = x;
+    }
+
+    delta = xq - acc->mean;
+    acc->mean += delta / (S64)acc->n;
+    acc->m2   += (delta * (xq - acc->mean)) >> STAT_Q;
+}
+
+S32 Stat_Mean(P_STAT_ACC acc)
+{
+    return((S32)((acc->mean + STAT_ONE / 2) >> STAT_Q));
+}
+
+static U32 Stat_Div(S64 m2, U32 n)
+{
+    S64 v;
+
+    if(n == 0 || m2 <= 0)
+    {
+        return(0);
+    }
+    v = (m2 / n + STAT_ONE / 2) >> STAT_Q;
+    return((v > 0xFFFFFFFF) ? 0xFFFFFFFF : (U32)v);
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Var
+    Parameters      : acc
+    Return value    : variance, unit^2
+    Description     : Population variance, M2 / n.
+******************************************************************************/
+U32 Stat_Var(P_STAT_ACC acc)
+{
+    return(Stat_Div(acc->m2, acc->n));
+}
+
+/******************************************************************************
+    Routine Name    : Stat_VarS
+    Parameters      : acc
+    Return value    : variance, unit^2
+    Description     : Sample variance, M2 / (n - 1).
+******************************************************************************/
+U32 Stat_VarS(P_STAT_ACC acc)
+{
+    return(Stat_Div(acc->m2, acc->n - 1));
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Sqrt
+    Parameters      : x
+    Return value    : floor(sqrt(x))
+    Description     : Bitwise integer square root.
+******************************************************************************/
+U32 Stat_Sqrt(INT64U x)
+{
+    INT64U res = 0;
+    INT64U bit = (INT64U)1 << 62;
+
+    while(bit > x)
+    {
+        bit >>= 2;
+    }
+    while(bit)
+    {
+        if(x >= res + bit)
+        {
+            x  -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return((U32)res);
+}
+
+/******************************************************************************
+    Routine Name    : Stat_HalfWidth
+    Parameters      : acc, z10 (z x10, e.g. STAT_Z_95)
+    Return value    : half width of the confidence interval of the mean, unit
+    Description     : z * s / sqrt(n), 0xFFFFFFFF with less than 2 samples.
+******************************************************************************/
+U32 Stat_HalfWidth(P_STAT_ACC acc, U32 z10)
+{
+    INT64U varMean;     // s^2 / n, Q16
+
+    if(acc->n < 2)
+    {
+        return(0xFFFFFFFF);
+    }
+    if(acc->m2 <= 0)
+    {
+        return(0);
+    }
+
+    varMean = ((INT64U)acc->m2 << STAT_Q) / (acc->n - 1) / acc->n;
+    return((U32)(((INT64U)Stat_Sqrt(varMean) * z10 / 10 + STAT_ONE / 2) >> STAT_Q));
+}
+
+/******************************************************************************
+    Routine Name    : Stat_CiCheck
+    Parameters      : acc, lower, upper, z10
+    Return value    : STAT_INSIDE/STAT_OUTSIDE/STAT_UNSURE
+    Description     : Compare the confidence interval of the mean with the
+                      limits, used to stop sampling once the answer is clear.
+******************************************************************************/
+U32 Stat_CiCheck(P_STAT_ACC acc, S32 lower, S32 upper, U32 z10)
+{
+    S64 mean = Stat_Mean(acc);
+    S64 hw   = Stat_HalfWidth(acc, z10);
+
+    if(acc->n < 2)
+    {
+        return(STAT_UNSURE);
+    }
+    if(mean - hw >= lower && mean + hw <= upper)
+    {
+        return(STAT_INSIDE);
+    }
+    if(mean + hw < lower || mean - hw > upper)
+    {
+        return(STAT_OUTSIDE);
+    }
+    return(STAT_UNSURE);
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Wilson
+    Parameters      : k, n, k events in n trials
+                      z10, z x10
+                      plo, phi, the interval in units of STAT_RATE_FULL
+    Return value    : none
+    Description     : Wilson score interval of a proportion, unlike the normal
+                      one it stays useful for k = 0 (e.g. 0 of 100 packets lost
+                      gives 0 ~ 3.85% at z = 2).
+******************************************************************************/
+void Stat_Wilson(U32 k, U32 n, U32 z10, U32 * plo, U32 * phi)
+{
+    INT64U z2 = (INT64U)z10 * z10;                  // z^2 x100
+    INT64U denom, center, half;
+
+    if(n == 0)
+    {
+        *plo = 0;
+        *phi = STAT_RATE_FULL;
+        return;
+    }
+
+    denom  = (INT64U)n * 100 + z2;
+    center = (INT64U)k * 100 + z2 / 2;
+    // z * sqrt(k(n-k)/n + z^2/4) x100, the root taken x1000
+    half   = (INT64U)z10 * Stat_Sqrt((INT64U)k * (n - k) * 1000000 / n + z2 * 2500) / 100;
+
+    *plo = (center > half) ? (U32)((center - half) * STAT_RATE_FULL / denom) : 0;
+    *phi = (U32)((center + half) * STAT_RATE_FULL / denom);
+    if(*phi > STAT_RATE_FULL)
+    {
+        *phi = STAT_RATE_FULL;
+    }
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Cpk100
+    Parameters      : acc, lower, upper
+    Return value    : Cpk x100, 0 with less than 2 samples
+    Description     : min(upper - mean, mean - lower) / 3s, negative when the
+                      mean is outside the limits. A zero spread gives 9999.
+******************************************************************************/
+S32 Stat_Cpk100(P_STAT_ACC acc, S32 lower, S32 upper)
+{
+    S64 mean;
+    S64 margin;
+    U32 s;
+
+    if(acc->n < 2)
+    {
+        return(0);
+    }
+
+    mean   = acc->mean;
+    margin = ((S64)upper << STAT_Q) - mean;
+    if(mean - ((S64)lower << STAT_Q) < margin)
+    {
+        margin = mean - ((S64)lower << STAT_Q);
+    }
+
+    s = Stat_Sqrt(((INT64U)acc->m2 << STAT_Q) / (acc->n - 1));    // Q8
+    if(s == 0)
+    {
+        return((margin >= 0) ? 9999 : -9999);
+    }
+    return((S32)(margin * 100 / 3 / s));
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Log2
+    Parameters      : x, > 0
+    Return value    : log2(x), Q16
+    Description     : Integer part from the highest bit, 16 fraction bits by
+                      repeated squaring of the mantissa.
+******************************************************************************/
+S32 Stat_Log2(U32 x)
+{
+    U32 k = 0;
+    U32 i;
+    S32 res;
+    INT64U m;           // mantissa in [1, 2), Q30
+
+    if(x == 0)
+    {
+        return(0);
+    }
+
+    while((x >> k) > 1)
+    {
+        k++;
+    }
+    res = (S32)(k << 16);
+    m   = ((INT64U)x << 30) >> k;
+
+    for(i = 16; i > 0; i--)
+    {
+        m = (m * m) >> 30;
+        if(m >= ((INT64U)2 << 30))
+        {
+            m >>= 1;
+            res += 1 << (i - 1);
+        }
+    }
+    return(res);
+}
+
+/******************************************************************************
+    Routine Name    : Stat_SprtInit
+    Parameters      : sprt
+                      p0, failure rate of a good DUT, 1/1000
+                      p1, failure rate of a bad DUT, 1/1000, > p0
+                      conf, confidence of the decision, %, e.g. 95
+    Return value    : none
+    Description     : Wald's sequential probability ratio test on pass/fail
+                      samples. Both error risks are 100 - conf percent.
+******************************************************************************/
+void Stat_SprtInit(P_STAT_SPRT sprt, U32 p0, U32 p1, U32 conf)
+{
+    U32 risk;
+
+    if(p0 < 1)
+    {
+        p0 = 1;
+    }
+    if(p1 > 999)
+    {
+        p1 = 999;
+    }
+    if(p1 <= p0)
+    {
+        p1 = p0 + 1;
+    }
+    risk = (conf < 100 && conf > 50) ? 100 - conf : 5;
+
+    memset(sprt, 0, sizeof(STAT_SPRT));
+    sprt->okStep = Stat_Log2(1000 - p1) - Stat_Log2(1000 - p0);
+    sprt->ngStep = Stat_Log2(p1) - Stat_Log2(p0);
+    sprt->reject = Stat_Log2(100 - risk) - Stat_Log2(risk);
+    sprt->accept = -sprt->reject;
+}
+
+/******************************************************************************
+    Routine Name    : Stat_SprtAdd
+    Parameters      : sprt, ok
+    Return value    : STAT_INSIDE (good), STAT_OUTSIDE (bad) or STAT_UNSURE
+    Description     : Add one sample. The caller bounds the number of samples
+                      and decides by its own rule if it is still unsure.
+******************************************************************************/
+U32 Stat_SprtAdd(P_STAT_SPRT sprt, BOOL ok)
+{
+    sprt->n++;
+    if(ok)
+    {
+        sprt->llr += sprt->okStep;
+    }
+    else
+    {
+        sprt->ng++;
+        sprt->llr += sprt->ngStep;
+    }
+
+    if(sprt->llr <= sprt->accept)
+    {
+        return(STAT_INSIDE);
+    }
+    if(sprt->llr >= sprt->reject)
+    {
+        return(STAT_OUTSIDE);
+    }
+    return(STAT_UNSURE);
+}
+
+/******************************************************************************
+    Routine Name    : Stat_HistInit
+    Parameters      : hist, low, high
+    Return value    : none
+    Description     : Spread STAT_HIST_BINS equal bins over [low, high].
+******************************************************************************/
+void Stat_HistInit(P_STAT_HIST hist, S32 low, S32 high)
+{
+    memset(hist, 0, sizeof(STAT_HIST));
+    hist->low   = low;
+    hist->width = (high > low) ? ((U32)(high - low) + STAT_HIST_BINS - 1) / STAT_HIST_BINS : 1;
+    if(hist->width == 0)
+    {
+        hist->width = 1;
+    }
+}
+
+void Stat_HistAdd(P_STAT_HIST hist, S32 x)
+{
+    U32 i;
+
+    hist->n++;
+    if(x < hist->low)
+    {
+        hist->under++;
+        return;
+    }
+
+    i = (U32)(x - hist->low) / hist->width;
+    if(i >= STAT_HIST_BINS)
+    {
+        hist->over++;
+        return;
+    }
+    hist->bin[i]++;
+}
+
+/******************************************************************************
+    Routine Name    : Stat_HistPercentile
+    Parameters      : hist, pct (0..100)
+    Return value    : estimated percentile
+    Description     : Percentile sketch: found from the bin counts and
+                      interpolated inside the bin, so the error is less than
+                      one bin width. Samples outside the bins count as the
+                      edge values.
+******************************************************************************/
+S32 Stat_HistPercentile(P_STAT_HIST hist, U32 pct)
+{
+    U32 need, sum, i;
+
+    if(hist->n == 0)
+    {
+        return(0);
+    }
+
+    need = (hist->n * pct + 99) / 100;
+    if(need == 0)
+    {
+        need = 1;
+    }
+
+    sum = hist->under;
+    if(sum >= need)
+    {
+        return(hist->low);
+    }
+    for(i = 0; i < STAT_HIST_BINS; i++)
+    {
+        if(sum + hist->bin[i] >= need)
+        {
+            return(hist->low + (S32)(i * hist->width + (need - sum) * hist->width / hist->bin[i]));
+        }
+        sum += hist->bin[i];
+    }
+    return(hist->low + (S32)(STAT_HIST_BINS * hist->width));
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Classify
+    Parameters      : x, lower, upper
+    Return value    : STAT_BELOW/STAT_INSIDE/STAT_ABOVE
+    Description     : The one place where a value is compared with its limits,
+                      both limits belong to the range.
+******************************************************************************/
+U32 Stat_Classify(S32 x, S32 lower, S32 upper)
+{
+    if(x < lower)
+    {
+        return(STAT_BELOW);
+    }
+    if(x > upper)
+    {
+        return(STAT_ABOVE);
+    }
+    return(STAT_INSIDE);
+}
+
+BOOL Stat_InRange(S32 x, S32 lower, S32 upper)
+{
+    return(Stat_Classify(x, lower, upper) == STAT_INSIDE);
+}
+
+/******************************************************************************
+    Routine Name    : Stat_Limit
+    Parameters      : pitem, value (same unit as pitem->lower/upper)
+    Return value    : PASS/FAIL
+    Description     : Judge a measurement with the limits of its item.
+******************************************************************************/
+U32 Stat_Limit(P_ITEM_T pitem, S32 value)
+{
+    U32 ret;
+
+    ret = Stat_InRange(value, (S32)pitem->lower, (S32)pitem->upper) ? PASS : FAIL;
+    Dprintf("%s (%s): %d [%d, %d] %s\r\n", pitem->item, pitem->id, value, pitem->lower, pitem->upper, (ret == PASS) ? "PASS" : "FAIL");
+
+    return(ret);
+}
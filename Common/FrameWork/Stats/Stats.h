@@ -0,0 +1,90 @@
+/*******************************************************************************
+    Stats.h
+    Fixed-point measurement statistics
+
+    Copyright(C) 2010, Honeywell Integrated Technology (China) Co.,Ltd.
+    Security FCT team
+    All rights reserved.
+
+    History
+                ver.1.00    First release
+*******************************************************************************/
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#define STAT_Q          (8)         // fraction bits of the mean and M2
+
+// Stat_CiCheck results
+#define STAT_UNSURE     (0)         // the confidence interval crosses a limit
+#define STAT_INSIDE     (1)         // clearly inside [lower, upper]
+#define STAT_OUTSIDE    (2)         // clearly outside
+
+// Stat_Classify results, STAT_INSIDE for lower <= x <= upper
+#define STAT_BELOW      (3)
+#define STAT_ABOVE      (4)
+
+#define STAT_Z_95       (20)        // z x10, two-sided 95%
+#define STAT_Z_997      (30)        // z x10, two-sided 99.7%
+
+#define STAT_RATE_FULL  (100000)    // 100% as a rate, x1000 like the test list limits
+
+#define STAT_HIST_BINS  (32)
+#define STAT_SPRT_CONF  (99)        // default confidence of the sequential tests, %
+
+typedef struct
+{
+    U32 n;
+    S32 min;
+    S32 max;
+    S64 mean;                       // running mean, Q8
+    S64 m2;                         // sum of squared deviations, Q8
+
+} STAT_ACC, * P_STAT_ACC;
+
+typedef struct
+{
+    S32 llr;                        // log2 likelihood ratio bad/good, Q16
+    S32 okStep;                     // added for a good sample, < 0
+    S32 ngStep;                     // added for a bad sample, > 0
+    S32 accept;                     // llr <= accept: the DUT is good
+    S32 reject;                     // llr >= reject: the DUT is bad
+    U32 n;
+    U32 ng;                         // bad samples
+
+} STAT_SPRT, * P_STAT_SPRT;
+
+typedef struct
+{
+    S32 low;                        // lower edge of bin 0
+    U32 width;                      // bin width
+    U32 n;
+    U32 under;                      // samples below low
+    U32 over;                       // samples above the last bin
+    U32 bin[STAT_HIST_BINS];
+
+} STAT_HIST, * P_STAT_HIST;
+
+extern void Stat_Reset(P_STAT_ACC acc);
+extern void Stat_Add(P_STAT_ACC acc, S32 x);
+extern S32  Stat_Mean(P_STAT_ACC acc);
+extern U32  Stat_Var(P_STAT_ACC acc);
+extern U32  Stat_VarS(P_STAT_ACC acc);
+extern U32  Stat_HalfWidth(P_STAT_ACC acc, U32 z10);
+extern U32  Stat_CiCheck(P_STAT_ACC acc, S32 lower, S32 upper, U32 z10);
+extern U32  Stat_Sqrt(INT64U x);
+extern S32  Stat_Cpk100(P_STAT_ACC acc, S32 lower, S32 upper);
+extern void Stat_Wilson(U32 k, U32 n, U32 z10, U32 * plo, U32 * phi);
+
+extern S32  Stat_Log2(U32 x);
+extern void Stat_SprtInit(P_STAT_SPRT sprt, U32 p0, U32 p1, U32 conf);
+extern U32  Stat_SprtAdd(P_STAT_SPRT sprt, BOOL ok);
+
+extern void Stat_HistInit(P_STAT_HIST hist, S32 low, S32 high);
+extern void Stat_HistAdd(P_STAT_HIST hist, S32 x);
+extern S32  Stat_HistPercentile(P_STAT_HIST hist, U32 pct);
+
+extern U32  Stat_Classify(S32 x, S32 lower, S32 upper);
+extern BOOL Stat_InRange(S32 x, S32 lower, S32 upper);
+extern U32  Stat_Limit(P_ITEM_T pitem, S32 value);
+
+#endif
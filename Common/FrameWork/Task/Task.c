@@ -43,6 +43,7 @@ static void Prob_Init(void)
 
 static void SysRst(void)
 {
+    LOGFILE_Flush();    //־ûддNAND
     MERAK_ResetALL();
 #ifdef DEBUG
 	AT91C_BASE_RSTC->RSTC_RCR = (0xA5 << 24) | 0x01;    //Debug
@@ -142,6 +143,7 @@ void TASK_Init(void)
     
     OS_CREATECSEMA(&DutReady_Sem);
     OS_CREATECSEMA(&CommTest_Sem);
+    MERAK_Init();
 
 	OS_CREATETASK(&TCB_ScanDut,  "ScanDut Task",   ScanDut_Task,  TASKPRIO_SCAN_DUT, Stack_ScanDut);
 	OS_CREATETASK(&TCB_TEST, 	 "Test Task", 	   Test_Task,  	  TASKPRIO_TEST, 	 Stack_Test);
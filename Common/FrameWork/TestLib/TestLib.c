@@ -4,6 +4,7 @@
 //#define DEBUG_CYCLE_TEST  //zjm
 
 U8 barCode_List[5][20] = {0};
+U8 barCode_Slot = 0;        //һɨдDUTλ, ¼ʱ
 
 U32 DUT_CMD(P_ITEM_T pitem)  //////////////////////////////////////////////////
 {
@@ -47,6 +48,7 @@ void TEST_BarcodeScan(P_ITEM_T pitem)
 	    }
     }
 #endif
+    barCode_Slot = pitem->Channel;
 	pitem->retResult = PASS;
 }
 /******************************************************************************
@@ -59,6 +61,7 @@ void TEST_BarcodeWr(P_ITEM_T pitem)
 {
     U8 wrStr[30]={0};
 
+    barCode_Slot = pitem->Channel;
     sprintf((char *)wrStr, "%s%s", (char * )pitem->TestCmd, (char * )barCode_List[pitem->Channel]);
     strcpy((char * )pitem->TestCmd, (char *)wrStr);
 	memset(wrStr , 0, 30);
@@ -134,46 +137,13 @@ void TEST_PowerOn(P_ITEM_T pitem)
 ******************************************************************************/
 void TEST_PowerADJ(P_ITEM_T pitem)
 {
-    U8 i;
 	U32 volt;
 
-    pitem->retResult = FAIL;
-    
 	RLY_ON((U32)pitem->Channel);
     OS_Delay(50);
 
-    volt = (U32)AD_MeasureAutoRange(pitem->upper);
-
-    for(i = 0; i< 80; i++)      // step: 0.1V, 0.1*80 = 8V
-    {
-        volt = (U32)AD_MeasureAutoRange(pitem->upper);
-        Dprintf((char *)"%2d.%03dV", volt/1000, volt%1000);
-
-        if(volt >= pitem->upper)               // The real voltage is more than expected voltage.
-        {
-            if((volt - pitem->upper) < 100)    // The real voltage is approximate with expected voltage.
-            {
-                pitem->retResult = PASS;
-                break;
-            }
-            else
-            {
-            	PWR_SubDutVolt(2);           // Continue to adjust the voltage, Decrease it 0.2v.
-            }
-        }
-        else                                    // The real voltage is less than expected voltage.
-        {
-            if((pitem->upper - volt) < 100)    // The real voltage is approximate with expected voltage.
-            {
-                pitem->retResult = PASS;
-                break;
-            }
-            else
-            {
-            	PWR_AddDutVolt(2);           // Continue to adjust the voltage, Increase it 0.2v.
-            }
-        }
-    }
+    pitem->retResult = PWR_AdjustDutVolt(pitem->upper, 100, pitem->Channel, &volt);
+    Dprintf((char *)"%2d.%03dV", volt/1000, volt%1000);
     
 	RLY_OFF((U32)pitem->Channel);
     OS_Delay(100);
@@ -339,7 +309,7 @@ void TEST_VoltageTest(P_ITEM_T pitem)
 	RLY_ON((U32)pitem->Channel);//RELAYͨ
     OS_Delay(50);
 
-    volt = (U32)AD_MeasureAutoRange(pitem->upper);//ȡѹֵ
+    volt = (U32)AD_MeasureWindow(pitem->Channel, pitem->lower, pitem->upper, pitem->Param);//ȡѹֵ, Param: ADCλ, 0ΪԶ
 
 	RLY_OFF((U32)pitem->Channel);//رRELAYͨ
 
@@ -348,14 +318,68 @@ void TEST_VoltageTest(P_ITEM_T pitem)
 	
     OS_Delay(50);
 
-	if(volt >= pitem->lower && volt < pitem->upper)//ѹֵ
-	{
-		pitem->retResult = PASS;
-	}
-	else
-	{
-		pitem->retResult = FAIL;
-	}
+	pitem->retResult = Stat_Limit(pitem, volt);    //ѹֵ
+}
+
+/******************************************************************************
+    Routine Name    : TEST_VoltScan
+    Parameters      : pitems, num, "VSCAN", ÿͬVOLG_T:
+                      Channel ̵ͨ, lower/upper ֵ, Param ADCλ
+    Return value    : none, ÿitemretResult
+    Description     : һβһԵ. ٰͨ, ̵̼
+                      ̵ͨл; һͨ, һͨ, ̹
+                      һȶʱ; LCDֻɵˢ.
+******************************************************************************/
+#define VSCAN_SETTLE_MS     (50)
+
+void TEST_VoltScan(P_ITEM_T pitems, U32 num)
+{
+    U8 order[VSCAN_MAX];
+    U32 key[VSCAN_MAX];
+    U32 i, j, volt;
+    U8 prev = 0;
+    P_ITEM_T p;
+
+    if(num > VSCAN_MAX)
+    {
+        num = VSCAN_MAX;
+    }
+
+    for(i = 0; i < num; i++)    //, : , ͨ
+    {
+        key[i] = (AD_PlanRange(pitems[i].Channel, pitems[i].upper, FALSE) << 8) | pitems[i].Channel;
+        for(j = i; j > 0 && key[order[j - 1]] > key[i]; j--)
+        {
+            order[j] = order[j - 1];
+        }
+        order[j] = (U8)i;
+    }
+
+    for(i = 0; i < num; i++)
+    {
+        p = &pitems[order[i]];
+        if(p->Channel != prev)
+        {
+            if(prev)
+            {
+                RLY_OFF((U32)prev);     //ADֻܽһԵ
+            }
+            RLY_ON((U32)p->Channel);
+            AD_PlanRange(p->Channel, p->upper, TRUE);
+            OS_Delay(VSCAN_SETTLE_MS);
+            prev = p->Channel;
+        }
+
+        volt = (U32)AD_MeasureWindow(p->Channel, p->lower, p->upper, p->Param);
+        p->retResult = Stat_Limit(p, volt);
+        Dprintf("%s CH%d %2d.%03dV\r\n", p->item, p->Channel, volt/1000, volt%1000);
+    }
+
+    if(prev)
+    {
+        RLY_OFF((U32)prev);
+        OS_Delay(VSCAN_SETTLE_MS);
+    }
 }
 
 void TEST_CalcCurrTest(P_ITEM_T pitem)
@@ -394,14 +418,7 @@ void TEST_CalcCurrTest(P_ITEM_T pitem)
     sprintf((char * )str, "curr=%2d.%03dA", curr/1000, curr%1000);
 	LCD_DisplayALine(LCD_LINE2, (U8 *)str);
 
-	if(curr >= pitem->lower && curr < pitem->upper)
-	{
-		pitem->retResult = PASS;
-	}
-	else
-	{
-		pitem->retResult = FAIL;
-	}
+	pitem->retResult = Stat_Limit(pitem, curr);
 }
 /******************************************************************************
     Routine Name    : TEST_ReadCurrTest
@@ -409,12 +426,23 @@ void TEST_CalcCurrTest(P_ITEM_T pitem)
     Return value    : none
     Description     : DUT
 ******************************************************************************/
+#define CURR_RECENT_MS      (100)       //RCURR_Tȡ100msƽ
+#define CURR_SETTLE_MS      (300)       //CURAVG_Tȴȶ
+#define CURR_INRUSH_MS      (100)
+
 void TEST_ReadCurrTest(P_ITEM_T pitem)
 {
     U32 DutCur;
-    U8 str[10];
+    U8 str[20];
+    STAT_ACC acc;
+    U32 now;
     
-    if(PWR_GetDUTCur((U32 * )&DutCur) == FALSE) //ȡPowerDUT
+    now = OS_GetTime32();
+    if(PWRMON_Running() && PWRMON_Window(now - CURR_RECENT_MS, now, &acc))  //ж, ٶ
+    {
+        DutCur = (U32)Stat_Mean(&acc);
+    }
+    else if(PWR_GetDUTCur((U32 * )&DutCur) == FALSE) //ȡPowerDUT
     {
         pitem->retResult = FAIL;
         return;
@@ -423,14 +451,79 @@ void TEST_ReadCurrTest(P_ITEM_T pitem)
     sprintf((char * )str, "DutCurr=%2d.%03dA", DutCur/1000, DutCur%1000);
 	LCD_DisplayALine(LCD_LINE2, (U8 *)str);
 
-	if(DutCur >= pitem->lower && DutCur < pitem->upper)//ֵ
-	{
-		pitem->retResult = PASS;
-	}
-	else
-	{
-		pitem->retResult = FAIL;
-	}
+	pitem->retResult = Stat_Limit(pitem, DutCur);    //ֵ
+}
+
+/******************************************************************************
+    Routine Name    : TEST_InrushTest
+    Parameters      : pitem, Param: ϵĴ, 10msΪλ, 0Ϊ100ms
+    Return value    : none
+    Description     : ϵ, дڵ(mA). Լ20msһ,
+                      ֻܿϿĳ. бINRUSH_Tʱϵʱʼ
+******************************************************************************/
+void TEST_InrushTest(P_ITEM_T pitem)
+{
+    STAT_ACC acc;
+    U32 win;
+    U8 str[20];
+
+    win = pitem->Param ? pitem->Param * 10 : CURR_INRUSH_MS;
+    if(PWRMON_Window(PWRMON_OnTime(), PWRMON_OnTime() + win, &acc) == 0)
+    {
+        pitem->retResult = FAIL;
+        return;
+    }
+
+    Dprintf("Inrush %dmA, %d readings\r\n", acc.max, acc.n);
+    sprintf((char * )str, "Inrush=%2d.%03dA", acc.max/1000, acc.max%1000);
+	LCD_DisplayALine(LCD_LINE2, (U8 *)str);
+
+	pitem->retResult = Stat_Limit(pitem, acc.max);
+}
+
+/******************************************************************************
+    Routine Name    : TEST_CurrAvgTest
+    Parameters      : pitem, ȷDUT(), ȴȶȡ
+                      Param x 100ms(0Ϊ500ms)ƽ
+    Return value    : none
+    Description     : ȶ/ߵ, ƽֵ(mA)
+******************************************************************************/
+void TEST_CurrAvgTest(P_ITEM_T pitem)
+{
+    STAT_ACC acc;
+    U32 from, win, n;
+    BOOL own;
+    U8 str[20];
+
+    if(pitem->TestCmd[0] && DUT_CMD(pitem) == FALSE)
+    {
+        pitem->retResult = FAIL;
+        return;
+    }
+
+    own = (PWRMON_Running() == FALSE);  //ûڼʱֻڱڼ
+    if(own)
+    {
+        PWRMON_Start();
+    }
+    win  = pitem->Param ? pitem->Param * 100 : 500;
+    from = OS_GetTime32() + CURR_SETTLE_MS;
+    n = PWRMON_Window(from, from + win, &acc);
+    if(own)
+    {
+        PWRMON_Stop();
+    }
+    if(n == 0)
+    {
+        pitem->retResult = FAIL;
+        return;
+    }
+
+    Dprintf("Curr %dmA, %d~%dmA, %d readings\r\n", Stat_Mean(&acc), acc.min, acc.max, acc.n);
+    sprintf((char * )str, "Curr=%2d.%03dA", Stat_Mean(&acc)/1000, Stat_Mean(&acc)%1000);
+	LCD_DisplayALine(LCD_LINE2, (U8 *)str);
+
+	pitem->retResult = Stat_Limit(pitem, Stat_Mean(&acc));
 }
 
 /******************************************************************************
@@ -620,6 +713,98 @@ void TEST_AudioTest(P_ITEM_T pitem)
     }
 }
 
+/******************************************************************************
+    Routine Name    : TEST_AudioSweep
+    Parameters      : pitem, DUTػ, Param ͷֵx10mV,
+                      lower/upper ûдֵƵʵõķֵΧ
+    Return value    : none
+    Description     : AudMask.csvɨƵ, һƵͨ·ƵӦ
+******************************************************************************/
+void TEST_AudioSweep(P_ITEM_T pitem)
+{
+    static AUDIO_PT pts[AUDIO_SWEEP_MAX];
+    U32 num;
+
+    num = Audio_LoadMask(pts, AUDIO_SWEEP_MAX, (U16)pitem->lower, (U16)pitem->upper);
+    
+    if(pitem->Channel)
+    {
+        RLY_ON(pitem->Channel);
+    }
+    
+	OS_Delay(100);
+    
+    if(num && DUT_CMD(pitem) == TRUE)
+	{
+        pitem->retResult = (U32)Audio_Sweep(pts, num, pitem->Param * 10);
+    }
+    else
+    {
+        pitem->retResult = FAIL;
+    }
+    
+    if(pitem->Channel)
+    {
+        RLY_OFF(pitem->Channel);
+    }
+}
+
+/******************************************************************************
+    Routine Name    : TEST_DTMFTest
+    Parameters      : pitem, RspCmdPass ͵ִ, DUTӦӦͬ
+                      TestCmd DUTִ
+                      lower/upper ÿֵź/ʱ(, 0.08,0.06)
+                      Param 0ʱΪ: ÿParam ms, ֱʧ, ӡ
+                      ɿʱ, ж԰ʱ
+    Return value    : none
+    Description     : DTMFػ
+******************************************************************************/
+#define DTMF_TIME_MIN       (20)        //ʱ20ms
+
+void TEST_DTMFTest(P_ITEM_T pitem)
+{
+    U16 sig, spac;
+    U16 bestSig = 0, bestSpac = 0;
+
+    sig  = (U16)pitem->lower;
+    spac = (U16)pitem->upper;
+
+    if(pitem->Channel)
+    {
+        RLY_ON(pitem->Channel);
+    }
+    OS_Delay(100);
+
+    pitem->retResult = FAIL;
+    do
+    {
+        if(Audio_SendDTMF(pitem->RspCmdPass, sig, spac) == FALSE
+        || Cmd_Ack(DUT_COMM_PORT, pitem->TestCmd, pitem->RspCmdPass, pitem->RspCmdFail) != PASS)
+        {
+            break;
+        }
+        if(bestSig == 0)
+        {
+            pitem->retResult = PASS;    //ʱͨ
+        }
+        bestSig  = sig;
+        bestSpac = spac;
+        sig  = (sig > DTMF_TIME_MIN + pitem->Param) ? sig - pitem->Param : DTMF_TIME_MIN;
+        spac = (spac > DTMF_TIME_MIN + pitem->Param) ? spac - pitem->Param : DTMF_TIME_MIN;
+    }
+    while(pitem->Param && (sig != bestSig || spac != bestSpac));
+
+    if(pitem->Param)
+    {
+        Dprintf("DTMF shortest %d/%dms\r\n", bestSig, bestSpac);
+    }
+
+    if(pitem->Channel)
+    {
+        RLY_OFF(pitem->Channel);
+    }
+}
+
 void TEST_GenAudio(P_ITEM_T pitem)
 {
     U16 freq;
@@ -708,25 +893,31 @@ static U32 Get_IP_Address(U8 * ip_str)
     return(DestIpAddr);
 }
 
+#define NET_PING_MAX    (50)
+
 void TEST_EthernetTest(P_ITEM_T pitem)
 {
     U8 i;
 	U32 DestIpAddr;
+	U32 verdict = STAT_UNSURE;
+	STAT_SPRT sprt;
 	
     DestIpAddr = Get_IP_Address(pitem->RspCmdFail);
-	pitem->retResult = IP_Ping_Test(DestIpAddr);
 
-////////////////////////
-    for(i=0;i<50;i++)
+    // : 5%, 50%㻵, ȷֹͣ, NET_PING_MAX
+    Stat_SprtInit(&sprt, 50, 500, STAT_SPRT_CONF);
+    for(i=0; i<NET_PING_MAX && verdict == STAT_UNSURE; i++)
     {
-        if(IP_Ping_Test(DestIpAddr))
-        {
-            i++;
-        }
+        verdict = Stat_SprtAdd(&sprt, IP_Ping_Test(DestIpAddr));
         OS_Delay(50);
     }
-    Dprintf("IP test ok %d times of 50 times.\r\n",i);
-//////////////////////    
+    Dprintf("IP test ok %d times of %d times.\r\n", sprt.n - sprt.ng, sprt.n);
+
+    if(verdict == STAT_UNSURE)
+    {
+        verdict = (sprt.llr < 0) ? STAT_INSIDE : STAT_OUTSIDE;
+    }
+	pitem->retResult = (verdict == STAT_INSIDE) ? PASS : FAIL;
 }
 
 void TEST_NetLedTest(P_ITEM_T pitem)
@@ -740,6 +931,7 @@ void TEST_NetLedTest(P_ITEM_T pitem)
 
     EXTIO_ConfigureBitDirction(pitem->Channel, IO_INPUT);
 
+    // о: (0)5160, ȷֹͣ
     for(i=0;i<255;i++)
     {
         if((i % 10) == 0)
@@ -747,15 +939,19 @@ void TEST_NetLedTest(P_ITEM_T pitem)
             IP_SendPing(htonl(TestLedIpAddr), "ICMP echo request!", strlen("ICMP echo request!"), i);
         }
         EXTIO_ReadBit(pitem->Channel, &readData); 
-        OS_Delay(5);
 
     	if(readData == 0)
     	{
     	    cnt++;
     	}
+    	if(cnt >= 160 || (cnt > 5 && i + 1 - cnt >= 255 - 160 + 1))
+    	{
+    	    break;
+    	}
+        OS_Delay(5);
     }
         
-    Dprintf("0: %d\r\n",cnt);
+    Dprintf("0: %d of %d\r\n", cnt, (i < 255) ? i + 1 : i);
     if(cnt > 5 && cnt < 160)
     {
         pitem->retResult = PASS;
@@ -783,8 +979,7 @@ void TEST_BuzzTest(P_ITEM_T pitem)
     {
         if(DUT_CMD(pitem))
     	{
-	        OS_Delay(1000);
-            pitem->retResult = (U32)Audio_LoopTest(pitem->Param*100, pitem->lower, pitem->upper);
+            pitem->retResult = (U32)Audio_LoopTest(pitem->Param*100, pitem->lower, pitem->upper);   //ȴѺ
         }
     }
     
@@ -797,22 +992,34 @@ void TEST_BuzzTest(P_ITEM_T pitem)
 //gaoxi add Ƿһƽ
 
 #define     MAX_COLLECT_OBJ     200
+#define     HDLED_PERIOD_US     500         // 200㹲100ms
 
 void TEST_HDLedTest(P_ITEM_T pitem)
 {
 	U32 volt[MAX_COLLECT_OBJ],i;
+    U16 wave[MAX_COLLECT_OBJ];
+    WAVE_INFO info;
 
     RLY_ON((U32)pitem->Channel);
     OS_Delay(50);
     
-    for(i = 0; i < MAX_COLLECT_OBJ; i++)
+    if(WAVE_Capture(WAVE_ADC_CHN, HDLED_PERIOD_US, MAX_COLLECT_OBJ, wave) == FALSE)
     {
-//        volt[i] = (U32)Fast_AD_cal_value(_RANGE_L_0_40V);
+        RLY_OFF((U32)pitem->Channel);
+        pitem->retResult = FAIL;
+        return;
     }
     
     RLY_OFF((U32)pitem->Channel);
     OS_Delay(50);
     
+    for(i = 0; i < MAX_COLLECT_OBJ; i++)
+    {
+        volt[i] = wave[i];
+    }
+    WAVE_Analyse(wave, MAX_COLLECT_OBJ, HDLED_PERIOD_US, pitem->lower, pitem->upper, &info);
+    Dprintf("LED %dmV~%dmV, %d rise, %d fall, %dus, %d%%\r\n", info.min, info.max, info.rise, info.fall, info.period_us, info.duty);
+
     if(VolFlashJudge(volt, pitem->Param, pitem->lower, pitem->upper) == TRUE)
 	{
 		pitem->retResult = PASS;
@@ -823,6 +1030,48 @@ void TEST_HDLedTest(P_ITEM_T pitem)
 	}
 }
 
+//"0705: LED blink,,,,2,4,BLINK_T,,3,0\r\n"
+//˸Ƶ(Hz)[lower, upper]; Param: ̲, λ100ms.
+//ΪlowerƵʵ3, WAVE_AnalyseҪ2ز
+#define BLINK_PERIODS   3
+
+void TEST_BlinkTest(P_ITEM_T pitem)
+{
+    static U16 wave[WAVE_SAMPLES_MAX];
+    WAVE_INFO info;
+    U32 window, freq, period;
+
+    window = (pitem->Param ? pitem->Param : 1) * 100000;
+    if(pitem->lower && window < BLINK_PERIODS * (1000000000 / pitem->lower))    // lowerΪmHz
+    {
+        window = BLINK_PERIODS * (1000000000 / pitem->lower);
+    }
+    if(window > WAVE_SAMPLES_MAX * WAVE_PERIOD_MAX)
+    {
+        window = WAVE_SAMPLES_MAX * WAVE_PERIOD_MAX;
+    }
+    period = window / WAVE_SAMPLES_MAX;
+
+    RLY_ON((U32)pitem->Channel);
+    OS_Delay(50);
+    
+    if(WAVE_Capture(WAVE_ADC_CHN, period, WAVE_SAMPLES_MAX, wave) == FALSE)
+    {
+        RLY_OFF((U32)pitem->Channel);
+        pitem->retResult = FAIL;
+        return;
+    }
+    
+    RLY_OFF((U32)pitem->Channel);
+    OS_Delay(20);
+
+    WAVE_Analyse(wave, WAVE_SAMPLES_MAX, period, 0, 0, &info);
+    freq = info.period_us ? 1000000000 / info.period_us : 0;    // mHz, limitͬλ
+    Dprintf("LED %d.%03dHz, %d%%, %dmV~%dmV, %dms window\r\n", freq/1000, freq%1000, info.duty, info.min, info.max, window/1000);
+
+    pitem->retResult = Stat_Limit(pitem, freq);
+}
+
 void TEST_LedTest(P_ITEM_T pitem)
 {
 	U32 volt;
@@ -837,7 +1086,7 @@ void TEST_LedTest(P_ITEM_T pitem)
 	RLY_ON((U32)pitem->Channel);
     OS_Delay(200);
 
-    volt = (U32)AD_MeasureAutoRange(pitem->upper);
+    volt = (U32)AD_MeasureWindow(pitem->Channel, pitem->lower, pitem->upper, pitem->Param);
 
 	RLY_OFF((U32)pitem->Channel);
     OS_Delay(20);
@@ -845,14 +1094,7 @@ void TEST_LedTest(P_ITEM_T pitem)
     sprintf((char *)str, "%2d.%03dV", volt/1000, volt%1000);
     LCD_DisplayALine(LCD_LINE2, (U8 *)str);
 
-	if(volt >= pitem->lower && volt < pitem->upper)
-	{
-		pitem->retResult = PASS;
-	}
-	else
-	{
-		pitem->retResult = FAIL;
-	}
+	pitem->retResult = Stat_Limit(pitem, volt);
 }
 
 
@@ -871,6 +1113,159 @@ void TEST_PortRxTest(P_ITEM_T pitem)
 	pitem->retResult = PASS;
 }
 
+/******************************************************************************
+    Routine Name    : TEST_PortBerTest
+    Parameters      : pitem
+    Return value    : none
+    Description     : ʲ. TestCmdΪʱȷDUT, ʹػģʽ.
+                      ChannelΪԴ, ParamΪʱ(λ100ms, 0Ϊ1),
+                      lowerΪ(Byte/s), upperΪֽ(ppm, ʧֽҲ),
+                      ֡
+******************************************************************************/
+void TEST_PortBerTest(P_ITEM_T pitem)
+{
+    PRBS_RESULT res;
+    U32 time_ms;
+    U32 errs, errppm;
+    U8 str[24];
+
+    if(*pitem->TestCmd)
+    {
+        if(DUT_CMD(pitem) == FALSE)
+        {
+            pitem->retResult = FAIL;
+            return;
+        }
+    }
+
+    time_ms = pitem->Param ? (pitem->Param * 100) : 1000;
+    if(Cmd_PrbsLoop(pitem->Channel, time_ms, &res) == FALSE || res.txBytes == 0)
+    {
+        pitem->retResult = FAIL;
+        return;
+    }
+
+    errs = res.errBytes;
+    if(res.rxBytes < res.txBytes)
+    {
+        errs += res.txBytes - res.rxBytes;
+    }
+    errppm = (U32)((INT64U)errs * 1000000 / res.txBytes);
+
+    sprintf((char *)str, "%dB/s %dppm", res.bytesPerSec, errppm);
+    LCD_DisplayALine(LCD_LINE2, (U8 *)str);
+    Dprintf("PRBS tx %d rx %d err %d/%dbit ovr %d frm %d\r\n",
+            res.txBytes, res.rxBytes, res.errBytes, res.errBits, res.overrun, res.frameErr);
+
+    if(res.bytesPerSec * 1000 >= pitem->lower && errppm * 1000 <= pitem->upper
+       && res.overrun == 0 && res.frameErr == 0)
+    {
+        pitem->retResult = PASS;
+    }
+    else
+    {
+        pitem->retResult = FAIL;
+    }
+}
+
+/******************************************************************************
+    Routine Name    : TEST_CapStart
+    Parameters      : pitem
+    Return value    : none
+    Description     : ʼ¼շ, ParamΪλ(bit0 USART0 ... bit4 DBGU),
+                      0ΪMERAK, DUTAUX
+******************************************************************************/
+void TEST_CapStart(P_ITEM_T pitem)
+{
+    UsartCap_Start(pitem->Param);
+    pitem->retResult = PASS;
+}
+
+/******************************************************************************
+    Routine Name    : TEST_CapSave
+    Parameters      : pitem
+    Return value    : none
+    Description     : Ѵڼ¼浽NAND, TestCmdΪIPַʱͬʱUDP
+******************************************************************************/
+void TEST_CapSave(P_ITEM_T pitem)
+{
+    pitem->retResult = UsartCap_Save();
+
+    if(*pitem->TestCmd && pitem->retResult)
+    {
+        pitem->retResult = UsartCap_Send(Get_IP_Address(pitem->TestCmd));
+    }
+}
+
+/******************************************************************************
+    Routine Name    : TEST_ReadValue
+    Parameters      : pitem
+    Return value    : none
+    Description     : ͨDUT, RspCmdPassΪӦ(Cmd_Compile), RspCmdFailΪFail־.
+                      Ӧ"%v""%d"ʱ, ȡֵlowerupper֮
+******************************************************************************/
+void TEST_ReadValue(P_ITEM_T pitem)
+{
+    RSP_SPEC spec;
+    I32 value = 0;
+    U8 str[24];
+
+    Cmd_Compile(&spec, pitem->RspCmdPass, pitem->RspCmdFail);
+
+    if(Cmd_Trans(DUT_COMM_PORT, pitem->TestCmd, &spec, &value) != RSP_PASS)
+    {
+        pitem->retResult = FAIL;
+        return;
+    }
+
+    if(spec.scale == 0)
+    {
+        pitem->retResult = PASS;
+        return;
+    }
+
+    sprintf((char *)str, "DATA: %d", value);
+    LCD_DisplayALine(LCD_LINE2, (U8 *)str);
+
+    value *= 1000 / spec.scale;     // lower/upper ǳ1000ֵ
+    pitem->retResult = Stat_Limit(pitem, value);
+}
+
+/******************************************************************************
+    Routine Name    : TEST_StreamValue
+    Parameters      : pitem
+    Return value    : none
+    Description     : DUT(ADC), TestCmdֻһ. RspCmdPassΪ"%v""%d"
+                      Ӧ, ParamΪ(0Ϊ50). ƽֵlowerupper֮,
+                      ȷʱǰ, Cmd_StreamCheck. ǰʱTestCmd'='
+                      0DUTֹͣ, Cmd_StreamStop
+******************************************************************************/
+void TEST_StreamValue(P_ITEM_T pitem)
+{
+    RSP_SPEC spec;
+    STREAM_CHK chk;
+    U8 str[24];
+
+    Cmd_Compile(&spec, pitem->RspCmdPass, pitem->RspCmdFail);
+    if(spec.scale == 0)
+    {
+        pitem->retResult = FAIL;
+        return;
+    }
+    spec.scale = 1000;      // lower/upper ǳ1000ֵ
+
+    chk.lower    = pitem->lower;
+    chk.upper    = pitem->upper;
+    chk.varMax   = 0;
+    chk.minCount = 5;
+    chk.absVal   = FALSE;
+
+    pitem->retResult = Cmd_StreamCheck(DUT_COMM_PORT, pitem->TestCmd, &spec, pitem->Param ? pitem->Param : 50, &chk);
+
+    sprintf((char *)str, "AVG: %d/%d", Stat_Mean(&chk.acc), chk.acc.n);
+    LCD_DisplayALine(LCD_LINE2, (U8 *)str);
+}
+
 extern int  USB_Enum_Ok;
 
 void TEST_USB_DevTest(P_ITEM_T pitem)
@@ -898,14 +1293,7 @@ void TEST_ADinTest(P_ITEM_T pitem)
         adc *= 1000;
     }
     
-	if(adc >= pitem->lower && adc < pitem->upper)
-	{
-		pitem->retResult = PASS;
-	}
-	else
-	{
-		pitem->retResult = FAIL;
-	}
+	pitem->retResult = Stat_Limit(pitem, adc);
 }
 
 void TEST_KeyTest(P_ITEM_T pitem)
@@ -966,17 +1354,10 @@ void TEST_ReadData(P_ITEM_T pitem)
     //
     sq *= 1000;
     //GSMźǷںʵķΧ
-	if(sq >= pitem->lower && sq < pitem->upper)
-	{
-		pitem->retResult = PASS;
-	}
-	else
-	{
-		pitem->retResult = FAIL;
-	}
+	pitem->retResult = Stat_Limit(pitem, sq);
 }
 //BAR_SCA,BAR_WR,BAR_RD,WAITDUT,WAITKEY,DELAY,CMD,IO_CTL,EIO_CTL,RLY_CTL,PWR_ON,PWR_OFF,COMM_T,
-//IN16_T,GPIN_T,GPOUT_T,CURR_T,VOLG_T,ADC_T,RLY_T,AUDIO_T,NET_T,LED_T,BUZZ_T,NTLED_T,KEY_T,MAN_T,
+//IN16_T,GPIN_T,GPOUT_T,CURR_T,VOLG_T,ADC_T,RLY_T,AUDIO_T,NET_T,LED_T,BUZZ_T,NTLED_T,BLINK_T,KEY_T,MAN_T,
 
 const TEST_ID TestIdTab[] = 
 {
@@ -1005,25 +1386,35 @@ const TEST_ID TestIdTab[] =
 	{"GPOUT_T",  TEST_GpioOutTest},
 	{"VOLG_T",   TEST_VoltageTest},
 	{"RCURR_T",  TEST_ReadCurrTest},
+	{"INRUSH_T", TEST_InrushTest},
+	{"CURAVG_T", TEST_CurrAvgTest},
 	{"CCURR_T",  TEST_CalcCurrTest},
 	{"AUDIO_T",  TEST_AudioTest},
 	{"AUDGEN",   TEST_GenAudio},
 	{"AUDEND",   TEST_StopAudio},
+	{"AUDSWP",   TEST_AudioSweep},
+	{"AUDDTMF",  TEST_DTMFTest},
 	{"AUDFREQ",  TEST_DecAudioFreq},
 	{"AUDAMP",   TEST_CompAudioAmp},
 	{"NET_T",    TEST_EthernetTest},
 	{"BUZZ_T",   TEST_BuzzTest},
 	{"NTLED_T",  TEST_NetLedTest},
     {"HDLED_T",  TEST_HDLedTest},
+    {"BLINK_T",  TEST_BlinkTest},
 	{"MAN_T",    TEST_ManualTest},
 	{"LED_T",    TEST_LedTest},
 	{"IN4P_T",   TEST_In4pinTest},
 	{"PORTT_T",  TEST_PortTxTest},
 	{"PORTR_T",  TEST_PortRxTest},
+	{"PORTB_T",  TEST_PortBerTest},
+	{"CAP_ON",   TEST_CapStart},
+	{"CAP_SAV",  TEST_CapSave},
 	{"USBDV_T",  TEST_USB_DevTest},
 	{"KEY_T",    TEST_KeyTest},
 	{"ADC_T",    TEST_ADinTest},
     {"RDDA_T",   TEST_ReadData},
+    {"RDVAL_T",  TEST_ReadValue},
+    {"STRM_T",   TEST_StreamValue},
 };
 
 U8 Get_IdSum(void)
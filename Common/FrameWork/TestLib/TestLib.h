@@ -33,6 +33,7 @@
 
 #define ITEM_STR_MAX	24
 #define CMD_STR_MAX	    48
+#define VSCAN_MAX       (32)    // consecutive "VSCAN" lines measured as one scan
 #define ID_STR_MAX	    8
 #define LCD_LSTR_MAX	ITEM_STR_MAX+ITEM_STR_MAX
 
@@ -72,6 +73,7 @@ extern U8 Get_IdSum(void);
 extern const TEST_ID TestIdTab[];
 
 extern U32 DUT_CMD(P_ITEM_T pitem);
+extern void TEST_VoltScan(P_ITEM_T pitems, U32 num);
 
 #endif
 
@@ -32,14 +32,21 @@
 #include "CfgFile.h"
 #include "LogFile.h"
 #include "InitFile.h"
+#include "Stats.h"
+#include "RfRec.h"
 
 #include "Power_485.h"
+#include "PwrMon.h"
 #include "Comm_dut.h"
+#include "Comm_tmo.h"
 #include "Comm_485.h"
 #include "MCP3421_ADC.h"
+#include "AD_Cal.h"
+#include "Wave.h"
 #include "i2c_api.h"
 #include "Relay.h"
 #include "usart2.h"
+#include "UsartCap.h"
 #include "Scanner_USB.h"
 #include "ExtIO_485.h"
 #include "Audio.h"
@@ -69,13 +69,14 @@ typedef unsigned long	DWORD;
 
 /*  These types copy from cpu.h*/
 typedef unsigned char  	BOOLEAN;
-typedef unsigned long   INT64U;
+typedef unsigned long long INT64U;  // was unsigned long, only 32 bits on the ARM926
 typedef signed int      INT32S;
 typedef unsigned int    uint32_t;
 
 typedef signed char     S8;
 typedef signed short    S16;
 typedef signed int    	S32;
+typedef signed long long S64;
 
 typedef void (*func)();
 